@@ -0,0 +1,157 @@
+// Load test for the simulation server: opens N sessions and drives each one from its own
+// client thread with back-to-back /next-iteration requests, then reports throughput.
+//
+// Build: g++ -O2 -std=c++17 -pthread samples/load_test.cpp -o load_test
+// Usage: ./load_test [sessions] [seconds] [rows] [cols] [port] [hot_clients]
+//
+// Run it with 1, 2, 4, ... sessions against a server started with ECOSIM_THREADS set to
+// the number of cores: requests per second should grow with the number of sessions until
+// the cores are saturated, since each session is served on its own strand.
+//
+// With hot_clients > 0, that many extra clients hammer the first session at the same time
+// (a burst to one hot world). The server only lets a few requests wait on one session and
+// answers the rest with 503, so the other (cold) sessions keep their latency instead of
+// waiting for a free server thread. The report shows both groups separately.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Send one HTTP/1.0 request to localhost and return the full response (headers and body)
+std::string http_request(int port, const std::string &method, const std::string &path, const std::string &body = "") {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return "";
+    }
+
+    std::string request = method + " " + path + " HTTP/1.0\r\nHost: localhost\r\n";
+    if (!body.empty()) {
+        request += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    request += "\r\n" + body;
+    for (size_t sent = 0; sent < request.size();) {
+        ssize_t n = send(fd, request.data() + sent, request.size() - sent, 0);
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+
+    std::string response;
+    char buffer[65536];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, n);
+    }
+    close(fd);
+    return response;
+}
+
+// Read a response header (case-sensitive, as sent by the server)
+std::string header_value(const std::string &response, const std::string &name) {
+    size_t start = response.find("\r\n" + name + ": ");
+    if (start == std::string::npos) {
+        return "";
+    }
+    start += name.size() + 4;
+    return response.substr(start, response.find("\r\n", start) - start);
+}
+
+int main(int argc, char **argv) {
+    const int sessions = argc > 1 ? std::atoi(argv[1]) : 4;
+    const int seconds = argc > 2 ? std::atoi(argv[2]) : 10;
+    const int rows = argc > 3 ? std::atoi(argv[3]) : 100;
+    const int cols = argc > 4 ? std::atoi(argv[4]) : 100;
+    const int port = argc > 5 ? std::atoi(argv[5]) : 8080;
+    const int hot_clients = argc > 6 ? std::atoi(argv[6]) : 0;
+
+    // Open the sessions, each with its own world
+    std::vector<std::string> ids;
+    const std::string world = "{\"rows\":" + std::to_string(rows) + ",\"cols\":" + std::to_string(cols) +
+                              ",\"plants\":" + std::to_string(rows * cols / 4) + ",\"herbivores\":" + std::to_string(rows * cols / 20) +
+                              ",\"carnivores\":" + std::to_string(rows * cols / 100) + "}";
+    for (int i = 0; i < sessions; ++i) {
+        std::string id = header_value(http_request(port, "POST", "/start-simulation", world), "X-Session");
+        if (id.empty()) {
+            std::cerr << "Could not start a session on port " << port << "\n";
+            return 1;
+        }
+        ids.push_back(id);
+    }
+
+    // Drive every session from its own thread until the deadline; the extra hot clients
+    // all drive session 0. Completed, refused (503) and the slowest successful request are
+    // recorded per client.
+    const int num_clients = sessions + hot_clients;
+    std::vector<std::atomic<uint64_t>> completed(num_clients), refused(num_clients);
+    std::vector<double> slowest(num_clients, 0);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    std::vector<std::thread> clients;
+    for (int c = 0; c < num_clients; ++c) {
+        clients.emplace_back([&, c]() {
+            const std::string path = "/next-iteration?session=" + ids[c < sessions ? c : 0] + "&fields=type";
+            while (std::chrono::steady_clock::now() < deadline) {
+                const auto started = std::chrono::steady_clock::now();
+                const std::string response = http_request(port, "GET", path);
+                const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+                if (response.compare(0, 12, "HTTP/1.1 200") == 0) {
+                    completed[c]++;
+                    slowest[c] = std::max(slowest[c], elapsed);
+                } else if (response.compare(0, 12, "HTTP/1.1 503") == 0) {
+                    refused[c]++;
+                }
+            }
+        });
+    }
+    for (std::thread &client : clients) {
+        client.join();
+    }
+
+    uint64_t total = 0;
+    for (int c = 0; c < num_clients; ++c) {
+        total += completed[c];
+    }
+    for (int i = 0; i < sessions; ++i) {
+        http_request(port, "DELETE", "/sessions/" + ids[i]);
+    }
+    std::printf("%d sessions, %dx%d cells: %llu requests in %d s (%.1f req/s, %.1f per session)\n", sessions, rows, cols,
+                static_cast<unsigned long long>(total), seconds, double(total) / seconds, double(total) / seconds / sessions);
+
+    if (hot_clients > 0) {
+        uint64_t hot = completed[0], hot_refused = refused[0], cold = 0;
+        double hot_slowest = slowest[0], cold_slowest = 0;
+        for (int c = sessions; c < num_clients; ++c) {
+            hot += completed[c];
+            hot_refused += refused[c];
+            hot_slowest = std::max(hot_slowest, slowest[c]);
+        }
+        for (int i = 1; i < sessions; ++i) {
+            cold += completed[i];
+            cold_slowest = std::max(cold_slowest, slowest[i]);
+        }
+        std::printf("hot session (%d clients): %llu served, %llu refused with 503, slowest %.1f ms\n", hot_clients + 1,
+                    static_cast<unsigned long long>(hot), static_cast<unsigned long long>(hot_refused), hot_slowest);
+        if (sessions > 1) {
+            std::printf("cold sessions (%d): %.1f req/s each, slowest %.1f ms\n", sessions - 1, double(cold) / seconds / (sessions - 1), cold_slowest);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Restart benchmark: times what /start-simulation does to a session (new empty grid,
+// uniform placement of a fixed number of entities, restart and publication) for growing
+// grid sizes, in process and without HTTP.
+//
+// Build: g++ -O2 -std=c++17 -pthread -Isrc samples/restart_benchmark.cpp -o restart_benchmark
+// Usage: ./restart_benchmark [entities] [rounds]
+//
+// The grid comes from lazily zeroed pages, placement and the snapshot copy only touch the
+// placed cells, and the population comes from the request instead of a recount, so with
+// the entity count fixed the cost does not follow the number of cells. What remains is one
+// page fault per touched page (and freeing those pages with the previous world): it grows
+// while the grid has fewer pages than entities, then stays flat. With 10k entities, for
+// example, restart takes about the same time at 16M and at 100M cells.
+
+#include "session.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char **argv) {
+    const uint32_t entities = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    const int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+    const rules_t rules;
+    const uint32_t sizes[] = { 1000, 2000, 4000, 7000, 10000 };
+
+    std::printf("%12s %14s %14s %14s\n", "cells", "grid (ms)", "populate (ms)", "restart (ms)");
+    for (uint32_t size : sizes) {
+        session_t session(1);
+        double grid_ms = 0, populate_ms = 0, restart_ms = 0;
+        for (int round = 0; round < rounds; ++round) {
+            std::lock_guard<std::mutex> lock(session.mutex);
+            const auto started = std::chrono::steady_clock::now();
+            session.grid = grid_t(size, size);
+            const auto allocated = std::chrono::steady_clock::now();
+            changed_cells_t placed;
+            populate_grid(session.grid, session.gen, rules, entities * 8 / 10, entities * 15 / 100, entities / 20, &placed);
+            const auto populated = std::chrono::steady_clock::now();
+            population_t population;
+            population.plants = entities * 8 / 10;
+            population.herbivores = entities * 15 / 100;
+            population.carnivores = entities / 20;
+            session.restart(population, &placed);
+            const auto restarted = std::chrono::steady_clock::now();
+
+            grid_ms += std::chrono::duration<double, std::milli>(allocated - started).count();
+            populate_ms += std::chrono::duration<double, std::milli>(populated - allocated).count();
+            restart_ms += std::chrono::duration<double, std::milli>(restarted - populated).count();
+        }
+        std::printf("%12llu %14.3f %14.3f %14.3f\n", (unsigned long long)size * size, grid_ms / rounds, populate_ms / rounds, restart_ms / rounds);
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "simulation.h"
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+// Registro limitado das células alteradas entre versões publicadas da grade.
+//
+// Cada publicação recebe uma versão crescente e guarda os índices das células que
+// mudaram em relação à publicação anterior, como registrados pela própria simulação
+// (changed_cells_t), sem comparar a grade inteira. Um cliente que já tem a versão since
+// recebe apenas as células alteradas depois dela; se since for anterior ao trecho
+// guardado (ou a um reinício do mundo), precisa de um quadro completo.
+
+// Número máximo de publicações guardadas no registro
+static const size_t DELTA_LOG_MAXIMUM_ENTRIES = 256;
+
+// Função para decidir se vale a pena enviar um delta com changed células em vez da grade
+// completa (um delta custa 13 bytes por célula no quadro binário, a grade completa até 9)
+inline bool delta_pays_off(size_t changed, size_t num_cells) {
+    return changed * 13 < num_cells * 9;
+}
+
+class change_log_t {
+public:
+    // Recomeçar o registro a partir de um estado completo (novo mundo)
+    void reset(const grid_t &grid, uint64_t version) {
+        entries_.clear();
+        stored_cells_ = 0;
+        rows_ = grid.rows;
+        cols_ = grid.cols;
+        base_version_ = version;
+        version_ = version;
+    }
+
+    // Registrar uma nova publicação da grade com as células escritas desde a anterior,
+    // consumindo changed. Se o registro transbordou, a publicação vale como um mundo novo.
+    void record(const grid_t &grid, uint64_t version, changed_cells_t &changed) {
+        if (grid.rows != rows_ || grid.cols != cols_ || changed.overflow) {
+            reset(grid, version);
+            changed.clear();
+            return;
+        }
+
+        entry_t entry;
+        entry.version = version;
+        entry.cells.swap(changed.cells);
+        changed.clear();
+        std::sort(entry.cells.begin(), entry.cells.end());
+        entry.cells.erase(std::unique(entry.cells.begin(), entry.cells.end()), entry.cells.end());
+        entry.cells.shrink_to_fit();
+        stored_cells_ += entry.cells.size();
+        entries_.push_back(std::move(entry));
+        version_ = version;
+
+        // Descartar as publicações mais antigas quando o registro passa do limite
+        // (número de publicações, ou mais índices guardados do que células na grade)
+        while (!entries_.empty() && (entries_.size() > DELTA_LOG_MAXIMUM_ENTRIES || stored_cells_ > grid.size())) {
+            stored_cells_ -= entries_.front().cells.size();
+            base_version_ = entries_.front().version;
+            entries_.pop_front();
+        }
+    }
+
+    // Versão da última publicação
+    uint64_t version() const {
+        return version_;
+    }
+
+    // Memória ocupada pelos índices guardados, em bytes
+    size_t memory_bytes() const {
+        return stored_cells_ * sizeof(uint32_t);
+    }
+
+    // Liberar a memória do registro, mantendo apenas a versão (a próxima consulta
+    // precisará de um quadro completo)
+    void clear(uint64_t version) {
+        entries_.clear();
+        stored_cells_ = 0;
+        base_version_ = version;
+        version_ = version;
+    }
+
+    // Preencher cells com os índices (ordenados, sem repetição) das células alteradas
+    // depois da versão since. Retorna false se o registro não cobre since.
+    bool changes_since(uint64_t since, std::vector<uint32_t> &cells) const {
+        cells.clear();
+        if (since < base_version_ || since > version_) {
+            return false;
+        }
+        for (const entry_t &entry : entries_) {
+            if (entry.version > since) {
+                cells.insert(cells.end(), entry.cells.begin(), entry.cells.end());
+            }
+        }
+        std::sort(cells.begin(), cells.end());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+        return true;
+    }
+
+private:
+    struct entry_t {
+        uint64_t version;
+        std::vector<uint32_t> cells;
+    };
+
+    std::deque<entry_t> entries_;
+    size_t stored_cells_ = 0;
+    uint32_t rows_ = 0;
+    uint32_t cols_ = 0;
+    uint64_t base_version_ = 0;
+    uint64_t version_ = 0;
+};
@@ -0,0 +1,356 @@
+#pragma once
+
+#include "entity.h"
+#include "placement.h"
+#include "rules.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// Motor de ensemble: K mundos independentes avançados em lockstep.
+//
+// O layout é célula-major e mundo-minor: os K valores da mesma célula ficam
+// contíguos (índice célula * K + k), de modo que as lanes de um registrador
+// SIMD processam mundos diferentes. Cada lane só avança o seu gerador nas células
+// ocupadas no seu próprio mundo (com uma seleção sem desvios, que mantém os laços
+// sobre k vetorizáveis), de modo que a trajetória de um mundo depende apenas da
+// sua semente, e não das outras lanes nem do tamanho do ensemble.
+
+// Limites aceitos pelo endpoint /ensemble
+static const uint32_t MAXIMUM_ENSEMBLE_REPLICATES = 8192;
+static const uint32_t MAXIMUM_ENSEMBLE_ITERATIONS = 100000;
+
+// Limite do trabalho de uma requisição (réplicas × iterações × células), que roda inteira
+// na thread do pedido
+static const uint64_t MAXIMUM_ENSEMBLE_CELL_STEPS = 100000000;
+
+// Número de sorteios consumidos por célula ocupada (máximo usado por um carnívoro)
+static const uint32_t ENSEMBLE_DRAWS_PER_CELL = 5;
+
+// Defina o estado de um ensemble de mundos
+struct ensemble_t {
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    uint32_t lanes = 0;
+
+    // Estado atual e cópia temporária, no mesmo layout (célula * lanes + k)
+    std::vector<uint8_t> type, next_type;
+    std::vector<uint32_t> energy, next_energy;
+    std::vector<uint32_t> age, next_age;
+
+    // Um gerador xorshift32 por mundo e o buffer de sorteios da célula corrente
+    std::vector<uint32_t> rng;
+    std::vector<uint32_t> draws;
+};
+
+// Série temporal agregada (média e desvio padrão entre os mundos) de uma espécie
+struct ensemble_series_t {
+    std::vector<double> mean;
+    std::vector<double> stddev;
+};
+
+// Função para calcular o estado seguinte do gerador xorshift32
+inline uint32_t ensemble_advance_random(uint32_t state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Função para avançar o gerador xorshift32 de uma lane
+inline uint32_t ensemble_next_random(uint32_t &state) {
+    return state = ensemble_advance_random(state);
+}
+
+// Função para converter um sorteio de 32 bits em um inteiro entre 0 e n - 1
+inline uint32_t ensemble_pick(uint32_t draw, uint32_t n) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(draw) * n) >> 32);
+}
+
+// Função para converter uma probabilidade em um limiar comparável aos sorteios
+inline uint64_t ensemble_threshold(double probability) {
+    return static_cast<uint64_t>(probability * 4294967296.0);
+}
+
+// Função para criar um ensemble vazio com geradores derivados de uma semente
+inline ensemble_t ensemble_create(uint32_t rows, uint32_t cols, uint32_t lanes, uint64_t seed) {
+    ensemble_t ensemble;
+    ensemble.rows = rows;
+    ensemble.cols = cols;
+    ensemble.lanes = lanes;
+
+    size_t size = static_cast<size_t>(rows) * cols * lanes;
+    ensemble.type.assign(size, empty);
+    ensemble.energy.assign(size, 0);
+    ensemble.age.assign(size, 0);
+    ensemble.next_type.resize(size);
+    ensemble.next_energy.resize(size);
+    ensemble.next_age.resize(size);
+    ensemble.draws.resize(static_cast<size_t>(ENSEMBLE_DRAWS_PER_CELL) * lanes);
+
+    // splitmix64 para espalhar a semente entre as lanes (o xorshift não aceita estado zero)
+    ensemble.rng.resize(lanes);
+    for (uint32_t k = 0; k < lanes; ++k) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        ensemble.rng[k] = static_cast<uint32_t>(z) | 1u;
+    }
+    return ensemble;
+}
+
+// Função para posicionar as entidades iniciais em cada mundo do ensemble, sem repetir células
+inline void ensemble_populate(ensemble_t &ensemble, const rules_t &rules, uint32_t num_plants, uint32_t num_herbivores, uint32_t num_carnivores) {
+    const uint32_t K = ensemble.lanes;
+    const uint32_t num_cells = ensemble.rows * ensemble.cols;
+    const entity_t kinds[3] = {
+        { plant, rules.maximum_energy, 0 },
+        { herbivore, rules.maximum_energy, 0 },
+        { carnivore, rules.maximum_energy, 0 }
+    };
+    const uint32_t amounts[3] = { num_plants, num_herbivores, num_carnivores };
+
+    for (uint32_t k = 0; k < K; ++k) {
+        cell_sampler_t sampler(num_cells, (uint64_t)num_plants + num_herbivores + num_carnivores);
+        for (int kind = 0; kind < 3; ++kind) {
+            for (uint32_t n = 0; n < amounts[kind]; ++n) {
+                uint64_t offset = (static_cast<uint64_t>(ensemble_next_random(ensemble.rng[k])) * sampler.remaining()) >> 32;
+                size_t cell = sampler.select(offset);
+
+                ensemble.type[cell * K + k] = kinds[kind].type;
+                ensemble.energy[cell * K + k] = kinds[kind].energy;
+                ensemble.age[cell * K + k] = kinds[kind].age;
+            }
+        }
+    }
+}
+
+// Função para avançar todos os mundos do ensemble por uma etapa de tempo.
+// Cada lane segue as mesmas regras de /next-iteration: as decisões leem e
+// alteram a grade atual, enquanto plantas novas, movimentos de herbívoros e
+// mortes são gravados na cópia temporária que se torna a próxima grade.
+inline void ensemble_step(ensemble_t &ensemble, const rules_t &rules) {
+    const uint32_t K = ensemble.lanes;
+    const uint32_t rows = ensemble.rows;
+    const uint32_t cols = ensemble.cols;
+    const size_t size = ensemble.type.size();
+
+    const uint64_t plant_reproduction = ensemble_threshold(rules.plant_reproduction_probability);
+    const uint64_t herbivore_move = ensemble_threshold(rules.herbivore_move_probability);
+    const uint64_t herbivore_eat = ensemble_threshold(rules.herbivore_eat_probability);
+    const uint64_t herbivore_reproduction = ensemble_threshold(rules.herbivore_reproduction_probability);
+    const uint64_t carnivore_move = ensemble_threshold(rules.carnivore_move_probability);
+    const uint64_t carnivore_eat = ensemble_threshold(rules.carnivore_eat_probability);
+    const uint64_t carnivore_reproduction = ensemble_threshold(rules.carnivore_reproduction_probability);
+
+    uint8_t *type = ensemble.type.data();
+    uint32_t *energy = ensemble.energy.data();
+    uint32_t *age = ensemble.age.data();
+    uint8_t *next_type = ensemble.next_type.data();
+    uint32_t *next_energy = ensemble.next_energy.data();
+    uint32_t *next_age = ensemble.next_age.data();
+    uint32_t *rng = ensemble.rng.data();
+    uint32_t *draws = ensemble.draws.data();
+
+    std::memcpy(next_type, type, size * sizeof(uint8_t));
+    std::memcpy(next_energy, energy, size * sizeof(uint32_t));
+    std::memcpy(next_age, age, size * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < rows; ++i) {
+        for (uint32_t j = 0; j < cols; ++j) {
+            const size_t cell = static_cast<size_t>(i) * cols + j;
+            const size_t base = cell * K;
+
+            // Vizinhos na ordem cima, baixo, esquerda, direita; fora da grade a
+            // direção aponta para a própria célula, como em /next-iteration
+            const size_t neighbors[4] = {
+                i > 0 ? cell - cols : cell,
+                i < rows - 1 ? cell + cols : cell,
+                j > 0 ? cell - 1 : cell,
+                j < cols - 1 ? cell + 1 : cell
+            };
+            const bool inside[4] = { i > 0, i < rows - 1, j > 0, j < cols - 1 };
+
+            // Células vazias em todos os mundos só precisam envelhecer
+            uint32_t occupied = 0;
+            for (uint32_t k = 0; k < K; ++k) {
+                occupied |= type[base + k];
+            }
+
+            if (occupied != empty) {
+                for (uint32_t d = 0; d < ENSEMBLE_DRAWS_PER_CELL; ++d) {
+                    for (uint32_t k = 0; k < K; ++k) {
+                        const uint32_t advanced = ensemble_advance_random(rng[k]);
+                        rng[k] = type[base + k] != empty ? advanced : rng[k];
+                        draws[d * K + k] = advanced;
+                    }
+                }
+
+                for (uint32_t k = 0; k < K; ++k) {
+                    const size_t x = base + k;
+                    const uint32_t *r = draws + k;
+
+                    switch (type[x]) {
+                        case empty:
+                            break;
+                        case plant:
+                            if (r[0] < plant_reproduction) {
+                                size_t candidates[4];
+                                uint32_t count = 0;
+                                for (int d = 0; d < 4; ++d) {
+                                    if (inside[d] && type[neighbors[d] * K + k] == empty) {
+                                        candidates[count++] = neighbors[d];
+                                    }
+                                }
+                                if (count > 0) {
+                                    next_type[candidates[ensemble_pick(r[K], count)] * K + k] = plant;
+                                }
+                            }
+                            break;
+                        case herbivore:
+                            if (r[0] < herbivore_move) {
+                                size_t candidates[4];
+                                uint32_t count = 0;
+                                for (int d = 0; d < 4; ++d) {
+                                    if (inside[d] && type[neighbors[d] * K + k] == empty) {
+                                        candidates[count++] = neighbors[d];
+                                    }
+                                }
+                                if (count > 0) {
+                                    const size_t y = candidates[ensemble_pick(r[K], count)] * K + k;
+                                    next_type[y] = type[x];
+                                    next_energy[y] = energy[x];
+                                    next_age[y] = age[x];
+                                    next_type[x] = empty;
+                                }
+                            }
+
+                            if (r[2 * K] < herbivore_eat) {
+                                for (int d = 0; d < 4; ++d) {
+                                    const size_t y = neighbors[d] * K + k;
+                                    if (type[y] == plant) {
+                                        type[y] = empty;
+                                        energy[x] += 30;
+                                    }
+                                }
+                            }
+
+                            if (r[3 * K] < herbivore_reproduction && energy[x] > rules.threshold_energy_for_reproduction) {
+                                for (int d = 0; d < 4; ++d) {
+                                    const size_t y = neighbors[d] * K + k;
+                                    if (type[y] == empty) {
+                                        type[y] = herbivore;
+                                        energy[y] = rules.herbivore_initial_energy;
+                                        age[y] = rules.herbivore_initial_age;
+                                        energy[x] -= 10;
+                                        break;
+                                    }
+                                }
+                            }
+                            break;
+                        case carnivore:
+                            if (r[0] < carnivore_move) {
+                                const size_t y = neighbors[ensemble_pick(r[K], 4)] * K + k;
+                                if (type[y] == herbivore) {
+                                    type[y] = type[x];
+                                    energy[y] = energy[x];
+                                    age[y] = age[x];
+                                    type[x] = empty;
+                                }
+                            }
+
+                            if (r[2 * K] < carnivore_eat) {
+                                const size_t y = neighbors[ensemble_pick(r[3 * K], 4)] * K + k;
+                                if (type[y] == herbivore) {
+                                    type[y] = empty;
+                                    energy[x] += 50;
+                                }
+                            }
+
+                            if (r[4 * K] < carnivore_reproduction && energy[x] > rules.threshold_energy_for_reproduction) {
+                                for (int d = 0; d < 4; ++d) {
+                                    const size_t y = neighbors[d] * K + k;
+                                    if (type[y] == empty) {
+                                        type[y] = carnivore;
+                                        energy[y] = rules.carnivore_initial_energy;
+                                        age[y] = rules.carnivore_initial_age;
+                                        energy[x] -= 20;
+                                        break;
+                                    }
+                                }
+                            }
+                            break;
+                    }
+                }
+            }
+
+            // Atualizar a idade e energia de todas as lanes (sem desvios, vetorizável)
+            for (uint32_t k = 0; k < K; ++k) {
+                const size_t x = base + k;
+                age[x]++;
+                energy[x]--;
+                const bool dead = energy[x] == 0;
+                next_type[x] = dead ? static_cast<uint8_t>(empty) : next_type[x];
+                next_energy[x] = dead ? 0 : next_energy[x];
+                next_age[x] = dead ? 0 : next_age[x];
+            }
+        }
+    }
+
+    ensemble.type.swap(ensemble.next_type);
+    ensemble.energy.swap(ensemble.next_energy);
+    ensemble.age.swap(ensemble.next_age);
+}
+
+// Função para contar a população de cada espécie em cada mundo do ensemble
+inline void ensemble_population(const ensemble_t &ensemble, std::vector<uint32_t> &plants, std::vector<uint32_t> &herbivores, std::vector<uint32_t> &carnivores) {
+    const uint32_t K = ensemble.lanes;
+    const size_t num_cells = static_cast<size_t>(ensemble.rows) * ensemble.cols;
+    const uint8_t *type = ensemble.type.data();
+
+    plants.assign(K, 0);
+    herbivores.assign(K, 0);
+    carnivores.assign(K, 0);
+    uint32_t *p = plants.data();
+    uint32_t *h = herbivores.data();
+    uint32_t *c = carnivores.data();
+
+    for (size_t cell = 0; cell < num_cells; ++cell) {
+        const uint8_t *t = type + cell * K;
+        for (uint32_t k = 0; k < K; ++k) {
+            p[k] += t[k] == plant;
+            h[k] += t[k] == herbivore;
+            c[k] += t[k] == carnivore;
+        }
+    }
+}
+
+// Função para acrescentar a média e o desvio padrão de uma contagem à série
+inline void ensemble_record(ensemble_series_t &series, const std::vector<uint32_t> &counts) {
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    for (uint32_t count : counts) {
+        sum += count;
+        sum_squares += static_cast<double>(count) * count;
+    }
+    const double n = counts.empty() ? 1.0 : static_cast<double>(counts.size());
+    const double mean = sum / n;
+    series.mean.push_back(mean);
+    series.stddev.push_back(std::sqrt(std::max(0.0, sum_squares / n - mean * mean)));
+}
+
+// Função para executar o ensemble e coletar a série temporal da população
+inline void ensemble_run(ensemble_t &ensemble, const rules_t &rules, uint32_t iterations, ensemble_series_t &plants, ensemble_series_t &herbivores, ensemble_series_t &carnivores) {
+    std::vector<uint32_t> p, h, c;
+    for (uint32_t iteration = 0; iteration <= iterations; ++iteration) {
+        if (iteration > 0) {
+            ensemble_step(ensemble, rules);
+        }
+        ensemble_population(ensemble, p, h, c);
+        ensemble_record(plants, p);
+        ensemble_record(herbivores, h);
+        ensemble_record(carnivores, c);
+    }
+}
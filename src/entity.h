@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+static const uint32_t NUM_ROWS = 15;
+
+// Maior número de linhas ou colunas aceito para a grade
+static const uint32_t MAXIMUM_GRID_SIZE = 10000;
+
+// Defina as constantes para as probabilidades e valores iniciais
+const double PLANT_REPRODUCTION_PROBABILITY = 0.1;
+const double HERBIVORE_MOVE_PROBABILITY = 0.3;
+const double HERBIVORE_EAT_PROBABILITY = 0.4;
+const double HERBIVORE_REPRODUCTION_PROBABILITY = 0.05;
+const double CARNIVORE_MOVE_PROBABILITY = 0.3;
+const double CARNIVORE_EAT_PROBABILITY = 0.5;
+const double CARNIVORE_REPRODUCTION_PROBABILITY = 0.05;
+const uint32_t MAXIMUM_ENERGY = 100;
+const uint32_t THRESHOLD_ENERGY_FOR_REPRODUCTION = 80;
+const uint32_t HERBIVORE_INITIAL_ENERGY = 80;
+const uint32_t HERBIVORE_INITIAL_AGE = 0;
+const uint32_t CARNIVORE_INITIAL_ENERGY = 100;
+const uint32_t CARNIVORE_INITIAL_AGE = 0;
+
+// Defina os tipos de entidades
+enum entity_type { empty, plant, herbivore, carnivore };
+
+// Defina uma estrutura de entidade
+struct entity_t {
+    entity_type type;
+    uint32_t energy;
+    uint32_t age;
+};
+
+// Defina uma estrutura para representar uma posição
+struct pos_t {
+    int i;
+    int j;
+};
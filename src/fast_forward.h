@@ -0,0 +1,179 @@
+#pragma once
+
+#include "json.hpp"
+#include "scheduler.h"
+#include "session.h"
+#include "simulation.h"
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Avanço rápido de uma sessão até uma condição sobre a população.
+//
+// O mundo avança em uma cópia privada da grade, na velocidade do motor: sem bloquear o
+// mutex, sem publicar e sem codificar quadros a cada iteração. As condições são avaliadas
+// sobre a contagem da população mantida pela própria simulação, sem percorrer a grade.
+// Ao parar, o resultado volta para a sessão e é publicado uma única vez. O avanço roda na
+// classe de lote do escalonador e cede o slot entre iterações a cada quantum.
+//
+// Um pedido ocupa o strand da sessão por no máximo FAST_FORWARD_SLICE: se o tempo acaba
+// antes de uma condição de parada, o resultado parcial é publicado e a resposta informa
+// quantas iterações faltam, para que o cliente retome o avanço com outro pedido. Avanços
+// mais longos devem usar os jobs (/jobs), que podem ser acompanhados e cancelados.
+
+// Maior número de iterações de um avanço rápido
+static const uint64_t MAXIMUM_FAST_FORWARD_TICKS = 1000000;
+
+// Tempo máximo de um pedido de avanço rápido no strand da sessão (pelo menos uma iteração
+// é simulada por pedido)
+static const std::chrono::milliseconds FAST_FORWARD_SLICE(500);
+
+// Defina uma condição de parada sobre a população de uma espécie (por exemplo,
+// { "species": "carnivores", "op": "<=", "value": 0 })
+struct population_condition_t {
+    entity_type species = plant;
+    std::string op = "<=";
+    uint32_t value = 0;
+};
+
+// Defina a especificação de um avanço rápido: limite de iterações e condições de parada
+struct fast_forward_spec_t {
+    uint64_t ticks = 0;
+    bool extinction = false;                     // parar quando uma espécie presente no início desaparece
+    std::vector<population_condition_t> until;   // parar quando qualquer condição for verdadeira
+};
+
+// Função para ler a contagem de uma espécie
+inline uint32_t species_count(const population_t &population, entity_type species) {
+    return species == plant ? population.plants : species == herbivore ? population.herbivores : population.carnivores;
+}
+
+// Função para avaliar uma condição sobre a população
+inline bool condition_holds(const population_condition_t &condition, const population_t &population) {
+    const uint32_t count = species_count(population, condition.species);
+    if (condition.op == "<") {
+        return count < condition.value;
+    } else if (condition.op == "<=") {
+        return count <= condition.value;
+    } else if (condition.op == "==") {
+        return count == condition.value;
+    } else if (condition.op == ">=") {
+        return count >= condition.value;
+    }
+    return count > condition.value;
+}
+
+// Função para converter a requisição JSON em uma especificação de avanço rápido
+inline fast_forward_spec_t fastForwardSpecFromJson(const nlohmann::json &request_body) {
+    fast_forward_spec_t spec;
+    spec.ticks = request_body.value("ticks", (uint64_t)0);
+    if (spec.ticks == 0 || spec.ticks > MAXIMUM_FAST_FORWARD_TICKS) {
+        throw std::invalid_argument("Número de iterações inválido");
+    }
+    spec.extinction = request_body.value("extinction", false);
+
+    const nlohmann::json until = request_body.value("until", nlohmann::json::array());
+    if (!until.is_array()) {
+        throw std::invalid_argument("until deve ser uma lista de condições");
+    }
+    for (const nlohmann::json &json_condition : until) {
+        population_condition_t condition;
+        const std::string species = json_condition.at("species").get<std::string>();
+        if (species == "plants") {
+            condition.species = plant;
+        } else if (species == "herbivores") {
+            condition.species = herbivore;
+        } else if (species == "carnivores") {
+            condition.species = carnivore;
+        } else {
+            throw std::invalid_argument("Espécie desconhecida: " + species);
+        }
+        condition.op = json_condition.value("op", std::string("<="));
+        if (condition.op != "<" && condition.op != "<=" && condition.op != "==" && condition.op != ">=" && condition.op != ">") {
+            throw std::invalid_argument("Operador desconhecido: " + condition.op);
+        }
+        condition.value = json_condition.at("value").get<uint32_t>();
+        spec.until.push_back(condition);
+    }
+    return spec;
+}
+
+// Função para avançar a sessão até uma condição de parada, o limite de iterações ou o fim
+// do tempo do pedido e descrever o estado final. Deve ser chamada no strand da sessão.
+inline nlohmann::json fast_forward(session_t &session, const fast_forward_spec_t &spec) {
+    const auto started = std::chrono::steady_clock::now();
+
+    // Só o strand altera a grade e o gerador, então a cópia dispensa o mutex
+    grid_t grid = session.grid;
+    std::mt19937 gen = session.gen;
+    population_t population = session.population;
+    const population_t initial = population;
+
+    std::string stop;
+    int condition_index = -1;
+    auto should_stop = [&]() {
+        for (size_t i = 0; i < spec.until.size(); ++i) {
+            if (condition_holds(spec.until[i], population)) {
+                stop = "condition";
+                condition_index = static_cast<int>(i);
+                return true;
+            }
+        }
+        if (spec.extinction && ((initial.plants > 0 && population.plants == 0) || (initial.herbivores > 0 && population.herbivores == 0) || (initial.carnivores > 0 && population.carnivores == 0))) {
+            stop = "extinction";
+            return true;
+        }
+        return false;
+    };
+
+    uint64_t done = 0;
+    changed_cells_t changed;
+    cpu_grant_t grant = engine_scheduler().acquire(session.account, batch_priority);
+    const auto deadline = std::chrono::steady_clock::now() + FAST_FORWARD_SLICE;
+    while (!should_stop()) {
+        if (done >= spec.ticks) {
+            stop = "ticks";
+            break;
+        }
+        if (done > 0 && std::chrono::steady_clock::now() >= deadline) {
+            stop = "deadline";
+            break;
+        }
+        grant.yield();
+        std::shared_ptr<const rules_t> rules = std::atomic_load(&session.rules); // Regras novas valem a partir desta iteração
+        simulate_iteration(grid, gen, *rules, &population, &changed);
+        ++done;
+    }
+    session.pacer.measure(done, std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+
+    // Devolver o mundo à sessão e publicá-lo uma vez
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (done > 0) {
+        session.grid = std::move(grid);
+        session.gen = gen;
+        session.population = population;
+        session.tick += done;
+        session.change_log.record(session.grid, next_publication_version(), changed);
+        session.publish();
+    }
+    const frame_header_t header = session.current_header();
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    nlohmann::json result = {
+        { "session", session.id },
+        { "tick", header.tick },
+        { "version", header.version },
+        { "ticks", done },
+        { "remaining", spec.ticks - done },
+        { "stop", stop },
+        { "population", { { "plants", population.plants }, { "herbivores", population.herbivores }, { "carnivores", population.carnivores } } },
+        { "elapsed", elapsed },
+        { "ticks_per_second", elapsed > 0 ? done / elapsed : 0.0 }
+    };
+    if (condition_index >= 0) {
+        result["condition"] = condition_index;
+    }
+    return result;
+}
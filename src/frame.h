@@ -0,0 +1,273 @@
+#pragma once
+
+#include "projection.h"
+#include "simulation.h"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Formato binário de quadros da grade.
+//
+// Todos os inteiros são little-endian. O cabeçalho tem 48 bytes:
+//
+//   0  magic "ECOF"      4 bytes
+//   4  versão            uint16 (a versão 1 tinha só os primeiros 32 bytes)
+//   6  flags             uint16 (FRAME_FLAG_RLE_TYPES, FRAME_FLAG_DELTA)
+//   8  linhas            uint32
+//  12  colunas           uint32
+//  16  iteração          uint64
+//  24  semente           uint64
+//  32  versão da grade   uint64 (cresce a cada publicação, inclusive entre mundos)
+//  40  base              uint64 (versão sobre a qual um quadro delta se aplica)
+//
+// Em um quadro completo vêm em seguida as colunas por célula, em ordem de linha:
+// energia (uint32 x N), idade (uint32 x N) e o plano de tipos. Sem RLE, o plano de
+// tipos tem um byte por célula; com RLE, tem o número de trechos (uint32), o
+// comprimento de cada trecho (uint32 x trechos) e o tipo de cada trecho (uint8 x trechos).
+//
+// Um quadro delta traz apenas as células alteradas desde a versão base: o número de
+// células (uint32), os índices (uint32 x M), a energia (uint32 x M), a idade
+// (uint32 x M) e o tipo (uint8 x M).
+//
+// Um quadro de região (FRAME_FLAG_REGION) traz a coluna x e a linha y da origem da
+// região (uint32 cada) logo após o cabeçalho; linhas e colunas são as da região.
+//
+// Com uma projeção, as colunas omitidas são marcadas nas flags e não aparecem no quadro
+// (as demais mantêm a ordem); energia e idade quantizadas trazem o início da faixa.
+//
+// Todas as colunas de 32 bits começam em posições múltiplas de 4, para serem lidas
+// direto como arrays tipados.
+
+// Tipo de conteúdo usado para negociar o formato binário (cabeçalho Accept)
+static const char *const FRAME_CONTENT_TYPE = "application/x-ecosim-frame";
+
+static const char FRAME_MAGIC[4] = { 'E', 'C', 'O', 'F' };
+static const uint16_t FRAME_VERSION = 2;
+static const size_t FRAME_HEADER_SIZE = 48;
+
+// O plano de tipos está codificado em trechos (run-length)
+static const uint16_t FRAME_FLAG_RLE_TYPES = 1;
+
+// O quadro traz apenas as células alteradas desde a versão base
+static const uint16_t FRAME_FLAG_DELTA = 2;
+
+// Colunas omitidas pela projeção
+static const uint16_t FRAME_FLAG_NO_ENERGY = 4;
+static const uint16_t FRAME_FLAG_NO_AGE = 8;
+static const uint16_t FRAME_FLAG_NO_TYPES = 16;
+
+// O quadro cobre apenas uma região retangular da grade
+static const uint16_t FRAME_FLAG_REGION = 32;
+
+// Defina os metadados gravados no cabeçalho de um quadro
+struct frame_header_t {
+    uint64_t tick = 0;
+    uint64_t seed = 0;
+    uint64_t version = 0;
+    uint64_t since = 0;
+    bool region = false;   // o quadro cobre apenas a região com origem (x, y)
+    uint32_t x = 0;
+    uint32_t y = 0;
+};
+
+// Função para escrever um inteiro little-endian de size bytes no fim do buffer
+inline void put_frame_integer(std::string &buffer, uint64_t value, size_t size) {
+    for (size_t byte = 0; byte < size; ++byte) {
+        buffer += static_cast<char>((value >> (8 * byte)) & 0xFF);
+    }
+}
+
+// Função para ler um inteiro little-endian de size bytes na posição offset do quadro
+inline uint64_t get_frame_integer(const std::string &frame, size_t offset, size_t size) {
+    if (offset + size > frame.size()) {
+        throw std::invalid_argument("Quadro truncado");
+    }
+    uint64_t value = 0;
+    for (size_t byte = 0; byte < size; ++byte) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(frame[offset + byte])) << (8 * byte);
+    }
+    return value;
+}
+
+// Função para contar os trechos de células consecutivas do mesmo tipo
+inline uint64_t count_type_runs(const grid_t &grid) {
+    uint64_t runs = 0;
+    for (size_t cell = 0; cell < grid.size(); ++cell) {
+        runs += cell == 0 || grid.cells[cell].type != grid.cells[cell - 1].type;
+    }
+    return runs;
+}
+
+// Função para calcular as flags das colunas omitidas pela projeção
+constexpr uint16_t projection_flags(unsigned fields) {
+    return ((fields & energy_field) ? 0 : FRAME_FLAG_NO_ENERGY) | ((fields & age_field) ? 0 : FRAME_FLAG_NO_AGE) | ((fields & type_field) ? 0 : FRAME_FLAG_NO_TYPES);
+}
+
+// Função para escrever o cabeçalho de um quadro no fim do buffer
+inline void write_frame_header(const grid_t &grid, const frame_header_t &header, uint16_t flags, std::string &buffer) {
+    buffer.append(FRAME_MAGIC, sizeof(FRAME_MAGIC));
+    put_frame_integer(buffer, FRAME_VERSION, 2);
+    put_frame_integer(buffer, flags | (header.region ? FRAME_FLAG_REGION : 0), 2);
+    put_frame_integer(buffer, grid.rows, 4);
+    put_frame_integer(buffer, grid.cols, 4);
+    put_frame_integer(buffer, header.tick, 8);
+    put_frame_integer(buffer, header.seed, 8);
+    put_frame_integer(buffer, header.version, 8);
+    put_frame_integer(buffer, header.since, 8);
+    if (header.region) {
+        put_frame_integer(buffer, header.x, 4);
+        put_frame_integer(buffer, header.y, 4);
+    }
+}
+
+// Função para escrever o quadro binário completo da grade, com os campos Fields, no fim
+// do buffer. O plano de tipos é codificado em trechos apenas quando isso o torna menor.
+template <unsigned Fields>
+void write_grid_frame(const grid_t &grid, const frame_header_t &header, uint32_t bucket, std::string &buffer) {
+    const size_t num_cells = grid.size();
+    const uint64_t runs = (Fields & type_field) ? count_type_runs(grid) : 0;
+    const bool rle = (Fields & type_field) && 4 + runs * 5 < num_cells;
+
+    buffer.reserve(buffer.size() + FRAME_HEADER_SIZE + num_cells * 9);
+    write_frame_header(grid, header, projection_flags(Fields) | (rle ? FRAME_FLAG_RLE_TYPES : 0), buffer);
+
+    if constexpr ((Fields & energy_field) != 0) {
+        for (const entity_t &entity : grid.cells) {
+            put_frame_integer(buffer, quantize(entity.energy, bucket), 4);
+        }
+    }
+    if constexpr ((Fields & age_field) != 0) {
+        for (const entity_t &entity : grid.cells) {
+            put_frame_integer(buffer, quantize(entity.age, bucket), 4);
+        }
+    }
+    if constexpr ((Fields & type_field) == 0) {
+        return;
+    }
+
+    if (!rle) {
+        for (const entity_t &entity : grid.cells) {
+            buffer += static_cast<char>(entity.type);
+        }
+        return;
+    }
+
+    put_frame_integer(buffer, runs, 4);
+    size_t run_start = 0;
+    for (size_t cell = 1; cell <= num_cells; ++cell) {
+        if (cell == num_cells || grid.cells[cell].type != grid.cells[run_start].type) {
+            put_frame_integer(buffer, cell - run_start, 4);
+            run_start = cell;
+        }
+    }
+    for (size_t cell = 0; cell < num_cells; ++cell) {
+        if (cell == 0 || grid.cells[cell].type != grid.cells[cell - 1].type) {
+            buffer += static_cast<char>(grid.cells[cell].type);
+        }
+    }
+}
+
+// Função para escrever no fim do buffer o quadro delta com os campos Fields das células indicadas
+template <unsigned Fields>
+void write_delta_frame(const grid_t &grid, const frame_header_t &header, const std::vector<uint32_t> &cells, uint32_t bucket, std::string &buffer) {
+    buffer.reserve(buffer.size() + FRAME_HEADER_SIZE + 4 + cells.size() * 13);
+    write_frame_header(grid, header, FRAME_FLAG_DELTA | projection_flags(Fields), buffer);
+    put_frame_integer(buffer, cells.size(), 4);
+    for (uint32_t cell : cells) {
+        put_frame_integer(buffer, cell, 4);
+    }
+    if constexpr ((Fields & energy_field) != 0) {
+        for (uint32_t cell : cells) {
+            put_frame_integer(buffer, quantize(grid.cells[cell].energy, bucket), 4);
+        }
+    }
+    if constexpr ((Fields & age_field) != 0) {
+        for (uint32_t cell : cells) {
+            put_frame_integer(buffer, quantize(grid.cells[cell].age, bucket), 4);
+        }
+    }
+    if constexpr ((Fields & type_field) != 0) {
+        for (uint32_t cell : cells) {
+            buffer += static_cast<char>(grid.cells[cell].type);
+        }
+    }
+}
+
+// Função para converter a grade em um quadro binário completo
+inline std::string gridToFrame(const grid_t &grid, const frame_header_t &header, const projection_t &projection = projection_t()) {
+    std::string buffer;
+    with_fields(projection.fields, [&](auto fields) {
+        write_grid_frame<fields()>(grid, header, projection.bucket, buffer);
+    });
+    return buffer;
+}
+
+// Função para converter as células alteradas em um quadro binário delta
+inline std::string deltaToFrame(const grid_t &grid, const frame_header_t &header, const std::vector<uint32_t> &cells, const projection_t &projection = projection_t()) {
+    std::string buffer;
+    with_fields(projection.fields, [&](auto fields) {
+        write_delta_frame<fields()>(grid, header, cells, projection.bucket, buffer);
+    });
+    return buffer;
+}
+
+// Função para ler um quadro binário completo, com todos os campos, de volta para a grade
+inline void frameToGrid(const std::string &frame, grid_t &grid, frame_header_t &header) {
+    if (frame.size() < FRAME_HEADER_SIZE || std::memcmp(frame.data(), FRAME_MAGIC, sizeof(FRAME_MAGIC)) != 0 || get_frame_integer(frame, 4, 2) != FRAME_VERSION) {
+        throw std::invalid_argument("Quadro inválido");
+    }
+    const uint16_t flags = static_cast<uint16_t>(get_frame_integer(frame, 6, 2));
+    if (flags & ~FRAME_FLAG_RLE_TYPES) {
+        throw std::invalid_argument("O quadro não é uma grade completa");
+    }
+    const uint32_t rows = static_cast<uint32_t>(get_frame_integer(frame, 8, 4));
+    const uint32_t cols = static_cast<uint32_t>(get_frame_integer(frame, 12, 4));
+    if (rows > MAXIMUM_GRID_SIZE || cols > MAXIMUM_GRID_SIZE) {
+        throw std::invalid_argument("Dimensões do quadro inválidas");
+    }
+    header = frame_header_t();
+    header.tick = get_frame_integer(frame, 16, 8);
+    header.seed = get_frame_integer(frame, 24, 8);
+    header.version = get_frame_integer(frame, 32, 8);
+
+    grid = grid_t(rows, cols);
+    const size_t num_cells = grid.size();
+    size_t offset = FRAME_HEADER_SIZE;
+    for (size_t cell = 0; cell < num_cells; ++cell, offset += 4) {
+        grid.cells[cell].energy = static_cast<uint32_t>(get_frame_integer(frame, offset, 4));
+    }
+    for (size_t cell = 0; cell < num_cells; ++cell, offset += 4) {
+        grid.cells[cell].age = static_cast<uint32_t>(get_frame_integer(frame, offset, 4));
+    }
+
+    auto type_at = [&](size_t position) {
+        const uint64_t type = get_frame_integer(frame, position, 1);
+        if (type > carnivore) {
+            throw std::invalid_argument("Tipo de entidade inválido no quadro");
+        }
+        return static_cast<entity_type>(type);
+    };
+    if (!(flags & FRAME_FLAG_RLE_TYPES)) {
+        for (size_t cell = 0; cell < num_cells; ++cell) {
+            grid.cells[cell].type = type_at(offset + cell);
+        }
+        return;
+    }
+    const uint64_t runs = get_frame_integer(frame, offset, 4);
+    const size_t lengths = offset + 4, types = lengths + runs * 4;
+    size_t cell = 0;
+    for (uint64_t run = 0; run < runs; ++run) {
+        const uint64_t length = get_frame_integer(frame, lengths + run * 4, 4);
+        const entity_type type = type_at(types + run);
+        if (cell + length > num_cells) {
+            throw std::invalid_argument("Trechos de tipos inválidos no quadro");
+        }
+        for (uint64_t k = 0; k < length; ++k) {
+            grid.cells[cell++].type = type;
+        }
+    }
+    if (cell != num_cells) {
+        throw std::invalid_argument("Trechos de tipos inválidos no quadro");
+    }
+}
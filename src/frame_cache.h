@@ -0,0 +1,125 @@
+#pragma once
+
+#include "frame.h"
+#include "grid_writer.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Cache de quadros já codificados.
+//
+// Todos os clientes que pedem a mesma publicação da grade, no mesmo formato, recebem o
+// mesmo texto: o primeiro pedido codifica e os demais reaproveitam o resultado (quem
+// chega enquanto a codificação está em andamento espera por ela, em vez de repeti-la).
+// Assim o custo de serialização cresce com o número de quadros, e não de espectadores.
+
+// Número de publicações mais recentes mantidas no cache
+static const uint64_t FRAME_CACHE_VERSIONS = 4;
+
+// Número máximo de quadros guardados no cache
+static const size_t FRAME_CACHE_MAXIMUM_ENTRIES = 64;
+
+// Defina os formatos de quadro
+enum frame_format { json_format, binary_format, png_format };
+
+// Defina a chave de um quadro codificado. A versão identifica a publicação (é única
+// mesmo entre mundos diferentes, ao contrário da iteração); since é a base de um delta
+// (0 para um quadro completo); projection identifica os campos incluídos e region, o
+// retângulo coberto ("" para a grade inteira).
+struct frame_key_t {
+    uint64_t version = 0;
+    uint64_t since = 0;
+    frame_format format = json_format;
+    std::string projection;
+    std::string region;
+
+    bool operator<(const frame_key_t &other) const {
+        return std::tie(version, since, format, projection, region) < std::tie(other.version, other.since, other.format, other.projection, other.region);
+    }
+};
+
+// Função para montar a ETag de um quadro
+inline std::string frameETag(const frame_key_t &key) {
+    return "\"" + std::to_string(key.version) + "-" + std::to_string(key.since) + (key.format == binary_format ? "-b" : key.format == png_format ? "-p" : "-j") +
+           (key.projection.empty() ? "" : "-" + key.projection) + (key.region.empty() ? "" : "-" + key.region) + "\"";
+}
+
+// Função para codificar a grade (ou as células alteradas, em um delta) no formato pedido
+inline std::string encodeFrame(const grid_t &grid, const frame_header_t &header, frame_format format, const std::vector<uint32_t> &cells, const projection_t &projection = projection_t()) {
+    if (header.since == 0) {
+        return format == binary_format ? gridToFrame(grid, header, projection) : gridToJsonString(grid, projection);
+    }
+    return format == binary_format ? deltaToFrame(grid, header, cells, projection) : deltaToJsonString(grid, header.version, header.since, cells, projection);
+}
+
+class frame_cache_t {
+public:
+    // Retornar o quadro da chave, codificando-o com encode se ainda não estiver no cache.
+    // hit indica se o quadro já estava pronto.
+    std::shared_ptr<const std::string> get(const frame_key_t &key, const std::function<std::string()> &encode, bool *hit = nullptr) {
+        std::shared_ptr<entry_t> entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it != entries_.end()) {
+                entry = it->second;
+            } else {
+                entry = std::make_shared<entry_t>();
+                entries_[key] = entry;
+                evict();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        if (hit) {
+            *hit = entry->body != nullptr;
+        }
+        if (!entry->body) {
+            entry->body = std::make_shared<const std::string>(encode());
+        }
+        return entry->body;
+    }
+
+    // Memória ocupada pelos quadros guardados, em bytes
+    size_t memory_bytes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t bytes = 0;
+        for (auto &entry : entries_) {
+            // Quadros ainda sendo codificados não entram na conta
+            std::unique_lock<std::mutex> entry_lock(entry.second->mutex, std::try_to_lock);
+            bytes += entry_lock.owns_lock() && entry.second->body ? entry.second->body->size() : 0;
+        }
+        return bytes;
+    }
+
+    // Descartar todos os quadros
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+    }
+
+private:
+    struct entry_t {
+        std::mutex mutex;
+        std::shared_ptr<const std::string> body;
+    };
+
+    // Descartar as publicações antigas e, se ainda houver quadros demais, os mais antigos
+    void evict() {
+        const uint64_t latest_version = entries_.rbegin()->first.version;
+        while (!entries_.empty()) {
+            const uint64_t oldest = entries_.begin()->first.version;
+            if (oldest + FRAME_CACHE_VERSIONS > latest_version && entries_.size() <= FRAME_CACHE_MAXIMUM_ENTRIES) {
+                break;
+            }
+            entries_.erase(entries_.begin());
+        }
+    }
+
+    std::mutex mutex_;
+    std::map<frame_key_t, std::shared_ptr<entry_t>> entries_;
+};
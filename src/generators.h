@@ -0,0 +1,311 @@
+#pragma once
+
+#include "json.hpp"
+#include "simulation.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Geradores procedurais do estado inicial.
+//
+// Cada espécie é posicionada segundo um mapa de densidade (uniforme, agrupado por um
+// processo de Thomas ou ruído coerente). A grade é dividida em blocos processados em
+// paralelo; todo sorteio vem de um hash de (semente, espécie, célula ou bloco), de modo
+// que o resultado depende apenas da semente, e não do número de threads.
+
+// Lado dos blocos processados em paralelo (em células)
+static const uint32_t GENERATOR_TILE_SIZE = 64;
+
+// Número máximo de registros de pais de agrupamentos nos blocos (cada pai é registrado
+// em todos os blocos a até 3 desvios padrão), que limita a memória e o trabalho do gerador
+static const uint64_t GENERATOR_MAXIMUM_PARENT_ENTRIES = 1 << 24;
+
+// Peso mínimo de uma célula vazia, que garante lugar para todas as entidades pedidas
+static const double GENERATOR_BACKGROUND_WEIGHT = 1e-6;
+
+// Defina os modos de distribuição inicial
+enum distribution_mode { uniform_distribution, clustered_distribution, noise_distribution };
+
+// Defina os parâmetros da distribuição inicial de uma espécie
+struct distribution_t {
+    distribution_mode mode = uniform_distribution;
+    uint32_t clusters = 0;   // número de agrupamentos (0 = um para cada 25 entidades)
+    double spread = 3.0;     // desvio padrão de cada agrupamento, em células
+    double scale = 16.0;     // tamanho das manchas da maior oitava do ruído, em células
+    uint32_t octaves = 4;    // número de oitavas do ruído
+    double contrast = 4.0;   // expoente aplicado ao ruído (valores maiores deixam as manchas mais nítidas)
+};
+
+// Função para misturar os bits de um inteiro de 64 bits (finalizador do splitmix64)
+inline uint64_t generator_mix(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Função para combinar uma semente com um identificador em um novo hash
+inline uint64_t generator_hash(uint64_t seed, uint64_t value) {
+    return generator_mix(seed ^ generator_mix(value));
+}
+
+// Função para converter um hash em um número real no intervalo aberto (0, 1)
+inline double generator_unit(uint64_t hash) {
+    return (static_cast<double>(hash >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+// Função para converter a descrição JSON de uma distribuição ("noise" ou { "mode": "noise", ... })
+inline distribution_t distributionFromJson(const nlohmann::json &json_distribution) {
+    distribution_t distribution;
+    const nlohmann::json options = json_distribution.is_object() ? json_distribution : nlohmann::json::object();
+    const std::string mode = json_distribution.is_string() ? json_distribution.get<std::string>() : options.value("mode", std::string("uniform"));
+
+    if (mode == "uniform") {
+        distribution.mode = uniform_distribution;
+    } else if (mode == "clustered") {
+        distribution.mode = clustered_distribution;
+    } else if (mode == "noise") {
+        distribution.mode = noise_distribution;
+    } else {
+        throw std::invalid_argument("Distribuição desconhecida: " + mode);
+    }
+
+    distribution.clusters = options.value("clusters", distribution.clusters);
+    distribution.spread = options.value("spread", distribution.spread);
+    distribution.scale = options.value("scale", distribution.scale);
+    distribution.octaves = options.value("octaves", distribution.octaves);
+    distribution.contrast = options.value("contrast", distribution.contrast);
+    if (!(distribution.spread > 0.0) || !(distribution.scale >= 1.0) || distribution.octaves == 0 || distribution.octaves > 16 || !(distribution.contrast > 0.0)) {
+        throw std::invalid_argument("Parâmetros de distribuição inválidos");
+    }
+    return distribution;
+}
+
+// Função para validar os parâmetros de uma distribuição para uma grade rows x cols com
+// count entidades da espécie: no máximo um agrupamento por entidade e dispersão até o
+// lado da grade
+inline void checkDistributionLimits(const distribution_t &distribution, uint32_t rows, uint32_t cols, uint64_t count) {
+    if (distribution.clusters > std::max<uint64_t>(1, count)) {
+        throw std::invalid_argument("Mais agrupamentos que entidades");
+    }
+    if (distribution.spread > std::max(rows, cols)) {
+        throw std::invalid_argument("Dispersão maior que a grade");
+    }
+    if (distribution.mode != clustered_distribution) {
+        return;
+    }
+
+    const uint64_t clusters = distribution.clusters > 0 ? distribution.clusters : std::max<uint64_t>(1, count / 25);
+    const uint64_t tiles_x = (cols + GENERATOR_TILE_SIZE - 1) / GENERATOR_TILE_SIZE;
+    const uint64_t tiles_y = (rows + GENERATOR_TILE_SIZE - 1) / GENERATOR_TILE_SIZE;
+    const uint64_t reach = static_cast<uint64_t>(std::ceil(6.0 * distribution.spread / GENERATOR_TILE_SIZE)) + 1;
+    if (clusters * std::min(reach, tiles_x) * std::min(reach, tiles_y) > GENERATOR_MAXIMUM_PARENT_ENTRIES) {
+        throw std::invalid_argument("Agrupamentos demais para a dispersão pedida");
+    }
+}
+
+// Defina o mapa de densidade de uma espécie sobre a grade
+class density_map_t {
+public:
+    density_map_t(const distribution_t &distribution, uint64_t seed, uint32_t rows, uint32_t cols, uint64_t count)
+        : distribution_(distribution), seed_(seed), rows_(rows), cols_(cols) {
+        if (distribution.mode != clustered_distribution) {
+            return;
+        }
+
+        // Processo de Thomas: pais uniformes, e cada um espalha descendentes com
+        // dispersão gaussiana. Os pais são registrados em todos os blocos alcançados
+        // por 3 desvios padrão, para que cada bloco consulte apenas os próximos.
+        tiles_x_ = (cols + GENERATOR_TILE_SIZE - 1) / GENERATOR_TILE_SIZE;
+        tiles_y_ = (rows + GENERATOR_TILE_SIZE - 1) / GENERATOR_TILE_SIZE;
+        parents_.resize(static_cast<size_t>(tiles_x_) * tiles_y_);
+
+        uint64_t clusters = distribution.clusters > 0 ? distribution.clusters : std::max<uint64_t>(1, count / 25);
+        const double reach = 3.0 * distribution.spread;
+        for (uint64_t c = 0; c < clusters; ++c) {
+            double i = rows * generator_unit(generator_hash(seed, 2 * c));
+            double j = cols * generator_unit(generator_hash(seed, 2 * c + 1));
+
+            int64_t ty0 = std::max<int64_t>(0, static_cast<int64_t>((i - reach) / GENERATOR_TILE_SIZE));
+            int64_t ty1 = std::min<int64_t>(tiles_y_ - 1, static_cast<int64_t>((i + reach) / GENERATOR_TILE_SIZE));
+            int64_t tx0 = std::max<int64_t>(0, static_cast<int64_t>((j - reach) / GENERATOR_TILE_SIZE));
+            int64_t tx1 = std::min<int64_t>(tiles_x_ - 1, static_cast<int64_t>((j + reach) / GENERATOR_TILE_SIZE));
+            for (int64_t ty = ty0; ty <= ty1; ++ty) {
+                for (int64_t tx = tx0; tx <= tx1; ++tx) {
+                    parents_[ty * tiles_x_ + tx].push_back({ i, j });
+                }
+            }
+        }
+    }
+
+    // Densidade relativa da célula (i, j), sem o peso mínimo de fundo
+    double weight(uint32_t i, uint32_t j) const {
+        switch (distribution_.mode) {
+            case clustered_distribution: {
+                const auto &parents = parents_[(i / GENERATOR_TILE_SIZE) * tiles_x_ + j / GENERATOR_TILE_SIZE];
+                const double inverse_variance = 1.0 / (2.0 * distribution_.spread * distribution_.spread);
+                double density = 0.0;
+                for (const auto &parent : parents) {
+                    double di = i + 0.5 - parent.first;
+                    double dj = j + 0.5 - parent.second;
+                    double distance = di * di + dj * dj;
+                    if (distance < 9.0 * distribution_.spread * distribution_.spread) {
+                        density += std::exp(-distance * inverse_variance);
+                    }
+                }
+                return density;
+            }
+            case noise_distribution:
+                return std::pow(noise(i, j), distribution_.contrast);
+            case uniform_distribution:
+            default:
+                return 1.0;
+        }
+    }
+
+private:
+    // Ruído de valor fractal em [0, 1]: valores sorteados por hash nos vértices de uma
+    // rede, interpolados suavemente e somados em oitavas de frequência crescente
+    double noise(uint32_t i, uint32_t j) const {
+        double total = 0.0;
+        double amplitude = 1.0;
+        double normalization = 0.0;
+        double scale = distribution_.scale;
+        for (uint32_t octave = 0; octave < distribution_.octaves; ++octave) {
+            double y = i / scale;
+            double x = j / scale;
+            int64_t y0 = static_cast<int64_t>(std::floor(y));
+            int64_t x0 = static_cast<int64_t>(std::floor(x));
+            double fy = y - y0;
+            double fx = x - x0;
+            fy = fy * fy * (3.0 - 2.0 * fy);
+            fx = fx * fx * (3.0 - 2.0 * fx);
+
+            uint64_t octave_seed = generator_hash(seed_, octave);
+            auto lattice = [&](int64_t ly, int64_t lx) {
+                return generator_unit(generator_hash(octave_seed, (static_cast<uint64_t>(ly) << 32) ^ static_cast<uint32_t>(lx)));
+            };
+            double top = lattice(y0, x0) + (lattice(y0, x0 + 1) - lattice(y0, x0)) * fx;
+            double bottom = lattice(y0 + 1, x0) + (lattice(y0 + 1, x0 + 1) - lattice(y0 + 1, x0)) * fx;
+
+            total += amplitude * (top + (bottom - top) * fy);
+            normalization += amplitude;
+            amplitude *= 0.5;
+            scale = std::max(1.0, scale * 0.5);
+        }
+        return total / normalization;
+    }
+
+    distribution_t distribution_;
+    uint64_t seed_;
+    uint32_t rows_;
+    uint32_t cols_;
+    uint32_t tiles_x_ = 0;
+    uint32_t tiles_y_ = 0;
+    std::vector<std::vector<std::pair<double, double>>> parents_;
+};
+
+// Função para repartir count entidades entre os blocos, proporcionalmente ao peso de
+// cada bloco (multinomial) e sem exceder as células vazias de cada um
+inline std::vector<uint64_t> allocate_to_tiles(uint64_t count, const std::vector<double> &weights, const std::vector<uint64_t> &capacity, std::mt19937_64 &gen) {
+    std::vector<uint64_t> allocation(weights.size(), 0);
+    uint64_t remaining = count;
+    while (remaining > 0) {
+        double total = 0.0;
+        for (size_t t = 0; t < weights.size(); ++t) {
+            if (allocation[t] < capacity[t]) {
+                total += weights[t];
+            }
+        }
+        if (!(total > 0.0)) {
+            break;
+        }
+
+        uint64_t left = remaining;
+        for (size_t t = 0; t < weights.size() && left > 0; ++t) {
+            if (allocation[t] >= capacity[t]) {
+                continue;
+            }
+            double p = total > 0.0 ? weights[t] / total : 1.0;
+            uint64_t drawn = p >= 1.0 ? left : std::binomial_distribution<uint64_t>(left, p)(gen);
+            total -= weights[t];
+            left -= drawn;
+
+            uint64_t taken = std::min(drawn, capacity[t] - allocation[t]);
+            allocation[t] += taken;
+            remaining -= taken;
+        }
+    }
+    return allocation;
+}
+
+// Função para posicionar count entidades iguais a entity em células vazias da grade,
+// seguindo o mapa de densidade da espécie
+inline void generate_species(grid_t &grid, const entity_t &entity, uint64_t count, const distribution_t &distribution, uint64_t seed) {
+    const uint32_t tiles_x = (grid.cols + GENERATOR_TILE_SIZE - 1) / GENERATOR_TILE_SIZE;
+    const uint32_t tiles_y = (grid.rows + GENERATOR_TILE_SIZE - 1) / GENERATOR_TILE_SIZE;
+    const size_t num_tiles = static_cast<size_t>(tiles_x) * tiles_y;
+    const density_map_t density(distribution, generator_hash(seed, 1), grid.rows, grid.cols, count);
+
+    auto for_each_empty_cell = [&](size_t tile, const std::function<void(uint32_t, uint32_t, double)> &visit) {
+        const uint32_t i0 = static_cast<uint32_t>(tile / tiles_x) * GENERATOR_TILE_SIZE;
+        const uint32_t j0 = static_cast<uint32_t>(tile % tiles_x) * GENERATOR_TILE_SIZE;
+        const uint32_t i1 = std::min(grid.rows, i0 + GENERATOR_TILE_SIZE);
+        const uint32_t j1 = std::min(grid.cols, j0 + GENERATOR_TILE_SIZE);
+        for (uint32_t i = i0; i < i1; ++i) {
+            for (uint32_t j = j0; j < j1; ++j) {
+                if (grid[i][j].type == empty) {
+                    visit(i, j, density.weight(i, j) + GENERATOR_BACKGROUND_WEIGHT);
+                }
+            }
+        }
+    };
+
+    // Primeira passada: peso total e células vazias de cada bloco
+    std::vector<double> weights(num_tiles, 0.0);
+    std::vector<uint64_t> capacity(num_tiles, 0);
+    parallel_for(num_tiles, [&](size_t tile) {
+        for_each_empty_cell(tile, [&](uint32_t, uint32_t, double weight) {
+            weights[tile] += weight;
+            capacity[tile]++;
+        });
+    });
+
+    std::mt19937_64 allocation_gen(generator_hash(seed, 2));
+    const std::vector<uint64_t> allocation = allocate_to_tiles(count, weights, capacity, allocation_gen);
+
+    // Segunda passada: dentro de cada bloco, amostragem ponderada sem reposição
+    // (Efraimidis-Spirakis: mantém as células com as maiores chaves log(u) / peso)
+    const uint64_t cell_seed = generator_hash(seed, 3);
+    parallel_for(num_tiles, [&](size_t tile) {
+        if (allocation[tile] == 0) {
+            return;
+        }
+        std::vector<std::pair<double, size_t>> keys;
+        keys.reserve(capacity[tile]);
+        for_each_empty_cell(tile, [&](uint32_t i, uint32_t j, double weight) {
+            size_t cell = static_cast<size_t>(i) * grid.cols + j;
+            keys.push_back({ std::log(generator_unit(generator_hash(cell_seed, cell))) / weight, cell });
+        });
+
+        auto chosen = keys.begin() + allocation[tile];
+        std::nth_element(keys.begin(), chosen - 1, keys.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+        for (auto it = keys.begin(); it != chosen; ++it) {
+            grid.cells[it->second] = entity;
+        }
+    });
+}
+
+// Função para gerar o estado inicial com uma distribuição por espécie (plantas, herbívoros, carnívoros)
+inline void generate_grid(grid_t &grid, const rules_t &rules, const uint32_t counts[3], const distribution_t distributions[3], uint64_t seed) {
+    const entity_type types[3] = { plant, herbivore, carnivore };
+    for (int species = 0; species < 3; ++species) {
+        if (counts[species] > 0) {
+            generate_species(grid, { types[species], rules.maximum_energy, 0 }, counts[species], distributions[species], generator_hash(seed, species));
+        }
+    }
+}
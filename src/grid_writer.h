@@ -0,0 +1,111 @@
+#pragma once
+
+#include "projection.h"
+#include "simulation.h"
+#include <charconv>
+#include <string>
+#include <vector>
+
+// Escrita da grade em JSON sem árvore intermediária.
+//
+// Produz exatamente o mesmo texto que nlohmann::json::dump() geraria para a grade
+// ([[{"age":0,"energy":100,"type":1},...],...], com as chaves em ordem alfabética),
+// mas escreve cada célula diretamente em um buffer de texto. Com uma projeção, cada
+// célula traz apenas os campos pedidos, na mesma ordem.
+
+// Função para escrever um inteiro sem sinal no fim do buffer
+inline void write_uint_json(uint32_t value, std::string &buffer) {
+    char digits[10];
+    char *end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    buffer.append(digits, end - digits);
+}
+
+// Função para escrever uma célula com os campos Fields no fim do buffer
+template <unsigned Fields>
+void write_entity_json(const entity_t &entity, uint32_t bucket, std::string &buffer) {
+    char separator = '{';
+    if constexpr ((Fields & age_field) != 0) {
+        buffer += separator;
+        buffer.append("\"age\":", 6);
+        write_uint_json(quantize(entity.age, bucket), buffer);
+        separator = ',';
+    }
+    if constexpr ((Fields & energy_field) != 0) {
+        buffer += separator;
+        buffer.append("\"energy\":", 9);
+        write_uint_json(quantize(entity.energy, bucket), buffer);
+        separator = ',';
+    }
+    if constexpr ((Fields & type_field) != 0) {
+        buffer += separator;
+        buffer.append("\"type\":", 7);
+        write_uint_json(entity.type, buffer);
+    }
+    buffer += '}';
+}
+
+// Função para escrever a grade com os campos Fields no fim do buffer
+template <unsigned Fields>
+void write_grid_json(const grid_t &grid, uint32_t bucket, std::string &buffer) {
+    buffer += '[';
+    for (uint32_t i = 0; i < grid.rows; ++i) {
+        if (i > 0) {
+            buffer += ',';
+        }
+        buffer += '[';
+        const entity_t *row = grid[i];
+        for (uint32_t j = 0; j < grid.cols; ++j) {
+            if (j > 0) {
+                buffer += ',';
+            }
+            write_entity_json<Fields>(row[j], bucket, buffer);
+        }
+        buffer += ']';
+    }
+    buffer += ']';
+}
+
+// Função para converter a grade de entidades em texto JSON de uma só vez
+inline std::string gridToJsonString(const grid_t &grid, const projection_t &projection = projection_t()) {
+    std::string buffer;
+    buffer.reserve(grid.size() * 32 + grid.rows * 3 + 2);
+    with_fields(projection.fields, [&](auto fields) {
+        write_grid_json<fields()>(grid, projection.bucket, buffer);
+    });
+    return buffer;
+}
+
+// Função para escrever em JSON as células alteradas desde a versão since, no formato
+// {"version":V,"since":S,"cells":[[índice,tipo,energia,idade],...]} (sem os campos
+// que ficaram fora da projeção)
+inline std::string deltaToJsonString(const grid_t &grid, uint64_t version, uint64_t since, const std::vector<uint32_t> &cells, const projection_t &projection = projection_t()) {
+    std::string buffer;
+    buffer.reserve(64 + cells.size() * 24);
+    buffer += "{\"version\":";
+    buffer += std::to_string(version);
+    buffer += ",\"since\":";
+    buffer += std::to_string(since);
+    buffer += ",\"cells\":[";
+    with_fields(projection.fields, [&](auto fields) {
+        for (size_t k = 0; k < cells.size(); ++k) {
+            const entity_t &entity = grid.cells[cells[k]];
+            buffer += k > 0 ? ",[" : "[";
+            write_uint_json(cells[k], buffer);
+            if constexpr ((fields() & type_field) != 0) {
+                buffer += ',';
+                write_uint_json(entity.type, buffer);
+            }
+            if constexpr ((fields() & energy_field) != 0) {
+                buffer += ',';
+                write_uint_json(quantize(entity.energy, projection.bucket), buffer);
+            }
+            if constexpr ((fields() & age_field) != 0) {
+                buffer += ',';
+                write_uint_json(quantize(entity.age, projection.bucket), buffer);
+            }
+            buffer += ']';
+        }
+    });
+    buffer += "]}";
+    return buffer;
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "json.hpp"
+#include "session.h"
+#include "simulation.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+// Jobs assíncronos que avançam o mundo de uma sessão por muitas iterações.
+//
+// Cada job roda em uma thread do serviço, separada das threads do servidor, em fatias de
+// até JOB_SLICE no strand da sessão. Ao fim de cada fatia o mundo é publicado e os outros
+// pedidos da sessão (quadros, regiões, WebSocket) passam antes da próxima fatia. O tempo de
+// CPU vem da classe de lote do escalonador, que dá a vez ao trabalho interativo de todas
+// as sessões a cada quantum.
+
+// Limites aceitos pelo serviço de jobs
+static const uint64_t MAXIMUM_JOB_TICKS = 1000000000;
+static const size_t MAXIMUM_ACTIVE_JOBS = 16;
+static const size_t MAXIMUM_FINISHED_JOBS = 64;
+
+// Duração máxima de uma fatia de um job no strand da sessão
+static const std::chrono::milliseconds JOB_SLICE(100);
+
+// Defina a especificação de um job: número de iterações e critérios de parada
+struct job_spec_t {
+    uint64_t ticks = 0;
+    bool extinction = false;   // parar quando uma espécie presente no início desaparece
+    uint32_t steady_window = 0; // parar quando a população não muda durante a janela (0 desliga)
+};
+
+// Defina o estado de um job, compartilhado entre a thread de execução e os handlers HTTP
+struct job_t {
+    uint64_t id = 0;
+    uint64_t session_id = 0;
+    std::weak_ptr<session_t> session; // um job não impede que a sessão seja encerrada
+    job_spec_t spec;
+    std::atomic<bool> cancelled{ false };
+    std::atomic<uint64_t> ticks{ 0 };
+
+    std::mutex mutex;
+    std::string status = "queued"; // queued, running, finished
+    std::string stop;              // ticks, extinction, steady_state, cancelled, session_closed
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point finished;
+};
+
+// Função para converter a requisição JSON em uma especificação de job
+inline job_spec_t jobSpecFromJson(const nlohmann::json &request_body) {
+    job_spec_t spec;
+    spec.ticks = request_body.value("ticks", (uint64_t)0);
+    if (spec.ticks == 0 || spec.ticks > MAXIMUM_JOB_TICKS) {
+        throw std::invalid_argument("Número de iterações inválido");
+    }
+    const nlohmann::json stop = request_body.value("stop", nlohmann::json::object());
+    if (!stop.is_object()) {
+        throw std::invalid_argument("stop deve ser um objeto");
+    }
+    spec.extinction = stop.value("extinction", false);
+    spec.steady_window = stop.value("steady_window", 0u);
+    return spec;
+}
+
+// Função para descrever o progresso de um job: iterações por segundo e tempo restante estimado
+inline nlohmann::json jobToJson(job_t &job) {
+    std::lock_guard<std::mutex> lock(job.mutex);
+    const uint64_t ticks = job.ticks;
+    nlohmann::json result = {
+        { "id", job.id },
+        { "session", job.session_id },
+        { "status", job.status },
+        { "ticks", ticks },
+        { "total", job.spec.ticks }
+    };
+    if (job.status == "queued") {
+        return result;
+    }
+
+    const auto end = job.status == "finished" ? job.finished : std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(end - job.started).count();
+    const double rate = elapsed > 0 ? ticks / elapsed : 0.0;
+    result["elapsed"] = elapsed;
+    result["ticks_per_second"] = rate;
+    if (job.status == "finished") {
+        result["stop"] = job.stop;
+    } else if (rate > 0) {
+        result["eta"] = (job.spec.ticks - ticks) / rate;
+    }
+    return result;
+}
+
+// Defina o serviço de jobs: registro de jobs e um conjunto limitado de threads de execução
+class job_service_t {
+public:
+    explicit job_service_t(unsigned num_threads = std::max(1u, std::thread::hardware_concurrency() / 2)) : pool_(num_threads) {}
+
+    // Criar um job e enfileirá-lo; retorna nullptr se já há jobs ativos demais
+    std::shared_ptr<job_t> submit(const std::shared_ptr<session_t> &session, const job_spec_t &spec) {
+        auto job = std::make_shared<job_t>();
+        job->session_id = session->id;
+        job->session = session;
+        job->spec = spec;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (active_ >= MAXIMUM_ACTIVE_JOBS) {
+                return nullptr;
+            }
+            ++active_;
+            job->id = next_id_++;
+            jobs_[job->id] = job;
+            forget_finished_jobs();
+        }
+
+        pool_.submit([this, job]() {
+            execute(*job);
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+        });
+        return job;
+    }
+
+    std::shared_ptr<job_t> find(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        return it == jobs_.end() ? nullptr : it->second;
+    }
+
+private:
+    // Executar o job em fatias até completar as iterações, cumprir um critério de parada
+    // ou ser cancelado
+    void execute(job_t &job) {
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.status = "running";
+            job.started = std::chrono::steady_clock::now();
+        }
+
+        const bool watch_population = job.spec.extinction || job.spec.steady_window > 0;
+        bool first_slice = true;
+        population_t initial, previous;
+        uint32_t unchanged = 0;
+        std::string stop;
+        while (stop.empty()) {
+            if (job.ticks >= job.spec.ticks) {
+                stop = "ticks";
+                break;
+            }
+            if (job.cancelled) {
+                stop = "cancelled";
+                break;
+            }
+            std::shared_ptr<session_t> session = job.session.lock();
+            if (!session) {
+                stop = "session_closed";
+                break;
+            }
+
+            session->run([&]() {
+                if (first_slice && watch_population) {
+                    initial = previous = session->population;
+                }
+                first_slice = false;
+
+                // Contar uma iteração e verificar os critérios de parada
+                auto count_tick = [&](const population_t &current) {
+                    ++job.ticks;
+                    if (watch_population) {
+                        const bool same = current.plants == previous.plants && current.herbivores == previous.herbivores && current.carnivores == previous.carnivores;
+                        unchanged = same ? unchanged + 1 : 0;
+                        previous = current;
+                        if (job.spec.extinction && ((initial.plants > 0 && current.plants == 0) || (initial.herbivores > 0 && current.herbivores == 0) || (initial.carnivores > 0 && current.carnivores == 0))) {
+                            stop = "extinction";
+                        } else if (job.spec.steady_window > 0 && unchanged >= job.spec.steady_window) {
+                            stop = "steady_state";
+                        }
+                    }
+                };
+
+                // Se uma iteração não cabe em um quantum do escalonador (ou seu custo ainda
+                // não é conhecido), simulá-la em fatias de linhas, uma por vez do strand
+                const double tick_seconds = session->pacer.tick_seconds();
+                if (tick_seconds <= 0 || tick_seconds > std::chrono::duration<double>(SCHEDULER_QUANTUM).count()) {
+                    if (session->advance_slice(SCHEDULER_QUANTUM, batch_priority)) {
+                        count_tick(session->population);
+                    }
+                    return;
+                }
+
+                // Jobs rodam na classe de lote e cedem o slot de CPU entre iterações
+                cpu_grant_t grant = engine_scheduler().acquire(session->account, batch_priority);
+                const auto deadline = std::chrono::steady_clock::now() + JOB_SLICE;
+                session->advance_while(job.spec.ticks - job.ticks, [&](const population_t &current) {
+                    count_tick(current);
+                    grant.yield();
+                    return stop.empty() && !job.cancelled && std::chrono::steady_clock::now() < deadline;
+                });
+            });
+        }
+
+        std::lock_guard<std::mutex> lock(job.mutex);
+        job.status = "finished";
+        job.stop = stop;
+        job.finished = std::chrono::steady_clock::now();
+    }
+
+    // Descartar os jobs terminados mais antigos acima do limite
+    void forget_finished_jobs() {
+        for (auto it = jobs_.begin(); jobs_.size() > MAXIMUM_FINISHED_JOBS + MAXIMUM_ACTIVE_JOBS && it != jobs_.end();) {
+            std::unique_lock<std::mutex> lock(it->second->mutex);
+            bool finished = it->second->status == "finished";
+            lock.unlock();
+            it = finished ? jobs_.erase(it) : std::next(it);
+        }
+    }
+
+    std::mutex mutex_;
+    std::map<uint64_t, std::shared_ptr<job_t>> jobs_;
+    uint64_t next_id_ = 1;
+    size_t active_ = 0;
+    thread_pool_t pool_; // destruído primeiro, antes do registro usado pelas tarefas
+};
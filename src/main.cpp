@@ -3,80 +3,134 @@
 
 #include "crow_all.h"
 #include "json.hpp"
+#include "rules.h"
+#include "simulation.h"
+#include "ensemble.h"
+#include "sweep.h"
+#include "generators.h"
+#include "grid_writer.h"
+#include "frame.h"
+#include "delta.h"
+#include "push.h"
+#include "snapshot.h"
+#include "session.h"
+#include "jobs.h"
+#include "tiles.h"
+#include "fast_forward.h"
+#include "speculation.h"
+#include <cerrno>
+#include <cstdlib>
 #include <random>
 #include <thread>
+#include <memory>
 #include <mutex>
 
-static const uint32_t NUM_ROWS = 15;
-
-// Defina as constantes para as probabilidades e valores iniciais
-const double PLANT_REPRODUCTION_PROBABILITY = 0.1;
-const double HERBIVORE_MOVE_PROBABILITY = 0.3;
-const double HERBIVORE_EAT_PROBABILITY = 0.4;
-const double HERBIVORE_REPRODUCTION_PROBABILITY = 0.05;
-const double CARNIVORE_MOVE_PROBABILITY = 0.3;
-const double CARNIVORE_EAT_PROBABILITY = 0.5;
-const double CARNIVORE_REPRODUCTION_PROBABILITY = 0.05;
-const uint32_t MAXIMUM_ENERGY = 100;
-const uint32_t THRESHOLD_ENERGY_FOR_REPRODUCTION = 80;
-const uint32_t HERBIVORE_INITIAL_ENERGY = 80;
-const uint32_t HERBIVORE_INITIAL_AGE = 0;
-const uint32_t CARNIVORE_INITIAL_ENERGY = 100;
-const uint32_t CARNIVORE_INITIAL_AGE = 0;
-
-// Defina os tipos de entidades
-enum entity_type { empty, plant, herbivore, carnivore };
-
-// Defina uma estrutura de entidade
-struct entity_t {
-    entity_type type;
-    uint32_t energy;
-    uint32_t age;
-};
-
-// Defina uma estrutura para representar uma posição
-struct pos_t {
-    int i;
-    int j;
-};
-
-// Defina um gerador de números aleatórios
-std::mt19937 gen(std::random_device{}());
-
-// Defina a grade de entidades
-std::vector<std::vector<entity_t>> entity_grid(NUM_ROWS, std::vector<entity_t>(NUM_ROWS, { empty, 0, 0 }));
-
-// Mutexes para exclusão mútua
-std::mutex grid_mutex;
-
-// Função para gerar um número inteiro aleatório entre min e max
-int random_integer(int min, int max) {
-    std::uniform_int_distribution<int> distribution(min, max);
-    return distribution(gen);
+// Defina o registro de sessões de simulação; cada sessão tem seu próprio mundo
+session_registry_t sessions;
+
+// Defina o serviço de varreduras de parâmetros (executadas sem interface em todos os núcleos)
+sweep_service_t sweeps;
+
+// Defina o serviço de jobs longos sobre as sessões (threads próprias, fora do servidor)
+job_service_t jobs;
+speculation_service_t speculation;
+
+// Função para ler um inteiro sem sinal de um parâmetro; retorna false se o texto não é
+// um número completo
+bool parseUnsigned(const char *text, uint64_t &value) {
+    char *end = nullptr;
+    errno = 0;
+    value = std::strtoull(text, &end, 10);
+    return text[0] >= '0' && text[0] <= '9' && *end == '\0' && errno == 0;
 }
 
-// Função para gerar um número de ponto flutuante aleatório entre 0 e 1
-double random_action(double probability) {
-    std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    return distribution(gen) < probability;
+// Função para ler a quantidade de entidades de uma espécie, que deve ser um inteiro sem sinal de 32 bits
+uint32_t readEntityCount(const nlohmann::json &request_body, const char *name) {
+    const nlohmann::json &count = request_body.at(name);
+    if (!count.is_number_unsigned() || count.get<uint64_t>() > UINT32_MAX) {
+        throw std::invalid_argument(std::string("Quantidade inválida para ") + name);
+    }
+    return count.get<uint32_t>();
 }
 
-// Função para converter a grade de entidades em um objeto JSON
-nlohmann::json entityGridToJson(const std::vector<std::vector<entity_t>>& grid) {
-    nlohmann::json json_grid;
-    for (const auto& row : grid) {
-        nlohmann::json json_row;
-        for (const auto& entity : row) {
-            nlohmann::json json_entity = {
-                { "type", entity.type },
-                { "energy", entity.energy },
-                { "age", entity.age }
-            };
-            json_row.push_back(json_entity);
-        }
-        json_grid.push_back(json_row);
+// Função para encontrar a sessão indicada por ?session=<id>; se ela não existe, responde 404.
+// Cada acesso marca a sessão como usada (o despejo por memória roda em segundo plano, ver
+// session_registry_t).
+std::shared_ptr<session_t> findSession(const crow::request &req, crow::response &res) {
+    const char *id = req.url_params.get("session");
+    std::shared_ptr<session_t> session = id ? sessions.find(std::strtoull(id, nullptr, 10)) : nullptr;
+    if (!session) {
+        res.code = 404;
+        res.body = "Sessão não encontrada";
+        res.end();
+        return session;
     }
-    return json_grid;
+    session->touch();
+    return session;
+}
+
+// Função para responder que a sessão tem pedidos demais esperando a vez (ver run_request)
+void respondBusy(crow::response &res) {
+    res.code = 503;
+    res.set_header("Retry-After", "1");
+    res.body = "Sessão ocupada: pedidos demais esperando";
+    res.end();
+}
+
+// Função para ler a projeção pedida (?fields= e ?quantize=); se ela é inválida, responde 400.
+// Deve ser chamada antes de alterar o mundo, para que um pedido recusado não o avance.
+bool readProjection(const crow::request &req, crow::response &res, projection_t &projection) {
+    try {
+        projection = projectionFromQuery(req.url_params.get("fields"), req.url_params.get("quantize"));
+    } catch (const std::invalid_argument &error) {
+        res.code = 400;
+        res.body = error.what();
+        res.end();
+        return false;
+    }
+    return true;
+}
+
+// Função para escrever a grade na resposta, em JSON ou no quadro binário se o cliente
+// o pedir no cabeçalho Accept. Com ?since=<versão>, envia apenas as células alteradas
+// depois dessa versão, ou a grade completa se o registro não a alcança mais. Cada
+// quadro é codificado uma vez e compartilhado pelo cache; um cliente que já tem o
+// quadro (If-None-Match igual à ETag) recebe 304 sem corpo. ?fields=type,energy,age
+// escolhe os campos enviados e ?quantize=<largura> arredonda energia e idade (ver
+// readProjection). Com o cabeçalho Prefer: return=minimal, responde 204 só com os
+// cabeçalhos (X-Version e ETag), sem codificar o quadro; o cliente o busca depois em /frame
+// ou segue com ?since. Deve ser chamada com o mutex da sessão bloqueado.
+void writeGridResponse(const crow::request &req, crow::response &res, session_t &session, const projection_t &projection) {
+    frame_header_t header = session.current_header();
+    frame_key_t key;
+    key.projection = projection.key();
+    key.version = header.version;
+    key.format = req.get_header_value("Accept").find(FRAME_CONTENT_TYPE) != std::string::npos ? binary_format : json_format;
+
+    std::vector<uint32_t> cells;
+    const char *since = req.url_params.get("since");
+    if (since && session.change_log.changes_since(std::strtoull(since, nullptr, 10), cells) && delta_pays_off(cells.size(), session.grid.size())) {
+        key.since = std::strtoull(since, nullptr, 10);
+    }
+    header.since = key.since;
+
+    const std::string etag = frameETag(key);
+    res.set_header("X-Version", std::to_string(header.version));
+    res.set_header("ETag", etag);
+    if (req.get_header_value("If-None-Match") == etag) {
+        res.code = 304;
+        return;
+    }
+    if (req.get_header_value("Prefer").find("return=minimal") != std::string::npos) {
+        res.code = 204;
+        res.set_header("Preference-Applied", "return=minimal");
+        return;
+    }
+    res.set_header("Content-Type", key.format == binary_format ? FRAME_CONTENT_TYPE : "application/json");
+
+    bool hit = false;
+    res.body = *session.frame_cache.get(key, [&]() { return encodeFrame(session.grid, header, key.format, cells, projection); }, &hit);
+    res.set_header("X-Cache", hit ? "hit" : "miss");
 }
 
 int main() {
@@ -84,351 +138,754 @@ int main() {
 
     // Endpoint para iniciar a simulação
     CROW_ROUTE(app, "/start-simulation").methods("POST"_method)([](crow::request &req, crow::response &res) {
-        // Analisar o corpo da solicitação JSON
-        nlohmann::json request_body = nlohmann::json::parse(req.body);
+        projection_t projection;
+        if (!readProjection(req, res, projection)) {
+            return;
+        }
 
-        // Validar a solicitação
-        uint32_t total_entities = (uint32_t)request_body["plants"] + (uint32_t)request_body["herbivores"] + (uint32_t)request_body["carnivores"];
-        if (total_entities > NUM_ROWS * NUM_ROWS) {
+        // Com ?session=<id>, recomeça o mundo dessa sessão; sem ele, cria uma sessão nova
+        std::shared_ptr<session_t> session;
+        if (req.url_params.get("session") && !(session = findSession(req, res))) {
+            return;
+        }
+
+        // Analisar o corpo da solicitação JSON e as quantidades de entidades
+        nlohmann::json request_body;
+        uint32_t num_plants, num_herbivores, num_carnivores;
+        uint64_t seed;
+        try {
+            request_body = nlohmann::json::parse(req.body);
+            num_plants = readEntityCount(request_body, "plants");
+            num_herbivores = readEntityCount(request_body, "herbivores");
+            num_carnivores = readEntityCount(request_body, "carnivores");
+
+            // A mesma semente reproduz o mesmo estado inicial
+            seed = request_body.contains("seed") ? request_body["seed"].get<uint64_t>() : (uint64_t(std::random_device{}()) << 32) | std::random_device{}();
+        } catch (const std::exception &error) {
+            res.code = 400;
+            res.body = error.what();
+            res.end();
+            return;
+        }
+
+        // Validar a solicitação (as dimensões da grade são opcionais)
+        uint32_t rows = request_body.value("rows", NUM_ROWS);
+        uint32_t cols = request_body.value("cols", NUM_ROWS);
+        if (rows == 0 || cols == 0 || rows > MAXIMUM_GRID_SIZE || cols > MAXIMUM_GRID_SIZE) {
+            res.code = 400;
+            res.body = "Dimensões da grade inválidas";
+            res.end();
+            return;
+        }
+
+        uint64_t total_entities = (uint64_t)num_plants + num_herbivores + num_carnivores;
+        if (total_entities > (uint64_t)rows * cols) {
             res.code = 400;
             res.body = "Muitas entidades";
             res.end();
             return;
         }
 
-        // Limpar a grade de entidades
-        std::lock_guard<std::mutex> lock(grid_mutex); // Bloquear o mutex durante a atualização
-        entity_grid.clear();
-        entity_grid.assign(NUM_ROWS, std::vector<entity_t>(NUM_ROWS, { empty, 0, 0 }));
+        // Validar as regras enviadas com a solicitação (se ausentes, as regras atuais da
+        // sessão são mantidas)
+        std::shared_ptr<const rules_t> rules = session ? std::atomic_load(&session->rules) : std::make_shared<const rules_t>();
+        if (request_body.contains("rules")) {
+            try {
+                rules = std::make_shared<const rules_t>(rulesFromJson(request_body["rules"]));
+            } catch (const std::invalid_argument &error) {
+                res.code = 400;
+                res.body = error.what();
+                res.end();
+                return;
+            }
+        }
 
-        // Criar as entidades (plantas, herbívoros e carnívoros) com base na solicitação
-        uint32_t num_plants = (uint32_t)request_body["plants"];
-        uint32_t num_herbivores = (uint32_t)request_body["herbivores"];
-        uint32_t num_carnivores = (uint32_t)request_body["carnivores"];
+        // Ler a distribuição inicial: um modo para todas as espécies ou um objeto por espécie
+        // (por exemplo, "clustered" ou { "plants": { "mode": "noise", "scale": 32 } })
+        const char *species_names[3] = { "plants", "herbivores", "carnivores" };
+        const uint32_t counts[3] = { num_plants, num_herbivores, num_carnivores };
+        distribution_t distributions[3];
+        bool uniform = true;
+        if (request_body.contains("distribution")) {
+            try {
+                const nlohmann::json &json_distribution = request_body["distribution"];
+                for (int species = 0; species < 3; ++species) {
+                    if (!json_distribution.is_object() || json_distribution.contains("mode")) {
+                        distributions[species] = distributionFromJson(json_distribution);
+                    } else if (json_distribution.contains(species_names[species])) {
+                        distributions[species] = distributionFromJson(json_distribution[species_names[species]]);
+                    }
+                    checkDistributionLimits(distributions[species], rows, cols, counts[species]);
+                    uniform = uniform && distributions[species].mode == uniform_distribution;
+                }
+            } catch (const std::exception &error) {
+                res.code = 400;
+                res.body = error.what();
+                res.end();
+                return;
+            }
+        }
 
-        for (uint32_t i = 0; i < num_plants; ++i) {
-            int row, col;
-            do {
-                row = random_integer(0, NUM_ROWS - 1);
-                col = random_integer(0, NUM_ROWS - 1);
-            } while (entity_grid[row][col].type != empty);
+        if (!session && !(session = sessions.create())) {
+            res.code = 429;
+            res.body = "Muitas sessões abertas";
+            res.end();
+            return;
+        }
 
-            entity_grid[row][col] = { plant, MAXIMUM_ENERGY, 0 };
+        // Recomeçar o mundo na vez da sessão, depois dos pedidos que chegaram antes
+        const bool accepted = session->run_request([&]() {
+            // Limpar a grade de entidades
+            std::lock_guard<std::mutex> lock(session->mutex); // Bloquear o mutex durante a atualização
+            session->grid = grid_t(rows, cols);
+            session->seed = seed;
+            session->tick = 0;
+            std::seed_seq seed_sequence{ uint32_t(seed), uint32_t(seed >> 32) };
+            session->gen.seed(seed_sequence);
+
+            // Criar as entidades (plantas, herbívoros e carnívoros) com base na solicitação.
+            // Todas cabem na grade, então a população é a pedida; o sorteio uniforme também
+            // lista as células preenchidas, e o recomeço copia só elas.
+            changed_cells_t placed;
+            if (uniform) {
+                populate_grid(session->grid, session->gen, *rules, num_plants, num_herbivores, num_carnivores, &placed);
+            } else {
+                generate_grid(session->grid, *rules, counts, distributions, seed);
+            }
+            std::atomic_store(&session->rules, rules);
+            population_t population;
+            population.plants = num_plants;
+            population.herbivores = num_herbivores;
+            population.carnivores = num_carnivores;
+            session->restart(population, uniform ? &placed : nullptr);
+            res.set_header("X-Session", std::to_string(session->id));
+            res.set_header("X-Seed", std::to_string(seed));
+
+            // Retornar a representação da grade de entidades
+            writeGridResponse(req, res, *session, projection);
+        });
+        if (!accepted) {
+            respondBusy(res);
+            return;
         }
+        res.end();
+        speculation.schedule(session);
+    });
 
-        for (uint32_t i = 0; i < num_herbivores; ++i) {
-            int row, col;
-            do {
-                row = random_integer(0, NUM_ROWS - 1);
-                col = random_integer(0, NUM_ROWS - 1);
-            } while (entity_grid[row][col].type != empty);
+    // Endpoint para a próxima iteração da simulação. O número de iterações do quadro é
+    // escolhido pelo pacer da sessão para caber no orçamento (?budget=<ms>, 16 ms por
+    // padrão) e devolvido no cabeçalho X-Ticks-Per-Frame; ?iterations=<n> o fixa. O cabeçalho
+    // conta as iterações de fato concluídas: 0 se a iteração em fatias foi interrompida por
+    // outro pedido que avançou o mundo.
+    CROW_ROUTE(app, "/next-iteration").methods("GET"_method)([](const crow::request &req, crow::response &res) {
+        const char *fixed = req.url_params.get("iterations");
+        const unsigned iterations = fixed ? std::strtoul(fixed, nullptr, 10) : 0;
+        if (fixed && (iterations == 0 || iterations > PACER_MAXIMUM_ITERATIONS)) {
+            res.code = 400;
+            res.body = "Número de iterações inválido";
+            res.end();
+            return;
+        }
+        projection_t projection;
+        if (!readProjection(req, res, projection)) {
+            return;
+        }
 
-            entity_grid[row][col] = { herbivore, MAXIMUM_ENERGY, 0 };
+        std::shared_ptr<session_t> session = findSession(req, res);
+        if (!session) {
+            return;
+        }
+        if (const char *budget = req.url_params.get("budget")) {
+            double milliseconds = 0;
+            if (!parse_frame_budget(budget, milliseconds)) {
+                res.code = 400;
+                res.body = "Orçamento de quadro inválido";
+                res.end();
+                return;
+            }
+            session->pacer.set_budget(milliseconds);
         }
+        // Se uma iteração não cabe no orçamento, simulá-la em fatias, atendendo os outros
+        // pedidos da sessão entre elas
+        const bool sliced = iterations == 0 && session->pacer.slice_iterations();
+        unsigned slices = 0;
+        bool completed = false;
+        if (sliced && (slices = session->advance_in_slices(session->pacer.budget(), &completed)) == 0) {
+            respondBusy(res);
+            return;
+        }
+        auto respond = [&]() {
+            bool speculated = false;
+            const unsigned done = sliced ? (completed ? 1 : 0) : session->advance(iterations, &speculated);
+            res.set_header("X-Speculation", speculated ? "hit" : "miss");
+            res.set_header("X-Ticks-Per-Frame", std::to_string(done));
+            res.set_header("X-Slices", std::to_string(slices));
+            res.set_header("X-Frame-Budget", std::to_string(session->pacer.budget_ms()));
+
+            // Retornar a representação da grade de entidades
+            std::lock_guard<std::mutex> lock(session->mutex);
+            writeGridResponse(req, res, *session, projection);
+        };
+        // A iteração em fatias já foi admitida; a resposta só lê o quadro publicado
+        if (sliced) {
+            session->run(respond);
+        } else if (!session->run_request(respond)) {
+            respondBusy(res);
+            return;
+        }
+        res.end();
 
-        for (uint32_t i = 0; i < num_carnivores; ++i) {
-            int row, col;
-            do {
-                row = random_integer(0, NUM_ROWS - 1);
-                col = random_integer(0, NUM_ROWS - 1);
-            } while (entity_grid[row][col].type != empty);
+        // Calcular os próximos lotes enquanto o cliente processa este quadro
+        speculation.schedule(session, iterations);
+    });
 
-            entity_grid[row][col] = { carnivore, MAXIMUM_ENERGY, 0 };
+    // Endpoint para avançar a sessão sem quadros intermediários até uma condição sobre a
+    // população ou o limite de iterações: { "ticks": 1000000, "extinction": true, "until":
+    // [{ "species": "carnivores", "op": "<=", "value": 0 }] }. Retorna a iteração em que
+    // parou, o motivo e a população final; a grade final é a publicação atual (/frame).
+    // Cada pedido roda por no máximo FAST_FORWARD_SLICE; com "stop": "deadline", o cliente
+    // retoma com outro pedido pelas iterações em "remaining".
+    CROW_ROUTE(app, "/fast-forward").methods("POST"_method)([](crow::request &req, crow::response &res) {
+        fast_forward_spec_t spec;
+        try {
+            spec = fastForwardSpecFromJson(nlohmann::json::parse(req.body));
+        } catch (const std::exception &error) {
+            res.code = 400;
+            res.body = error.what();
+            res.end();
+            return;
         }
 
-        // Retornar a representação JSON da grade de entidades
-        nlohmann::json json_grid = entityGridToJson(entity_grid);
-        res.body = json_grid.dump();
+        std::shared_ptr<session_t> session = findSession(req, res);
+        if (!session) {
+            return;
+        }
+        nlohmann::json result;
+        if (!session->run_request([&]() { result = fast_forward(*session, spec); })) {
+            respondBusy(res);
+            return;
+        }
+        res.set_header("Content-Type", "application/json");
+        res.body = result.dump();
         res.end();
+    });
 
+    // Endpoint para ler a publicação atual da grade sem avançar a simulação (aceita
+    // os mesmos parâmetros de /next-iteration)
+    CROW_ROUTE(app, "/frame").methods("GET"_method)([](const crow::request &req, crow::response &res) {
+        projection_t projection;
+        if (!readProjection(req, res, projection)) {
+            return;
+        }
+        std::shared_ptr<session_t> session = findSession(req, res);
+        if (!session) {
+            return;
+        }
+        if (!session->run_request([&]() {
+                std::lock_guard<std::mutex> lock(session->mutex);
+                writeGridResponse(req, res, *session, projection);
+            })) {
+            respondBusy(res);
+            return;
+        }
+        res.end();
     });
 
-    // Endpoint para a próxima iteração da simulação
-    CROW_ROUTE(app, "/next-iteration").methods("GET"_method)([]() {
-        // Iniciar a simulação em um loop (por exemplo, 100 iterações)
-        for (int iteration = 0; iteration < 100; ++iteration) {
-            // Simular a próxima iteração
-            std::lock_guard<std::mutex> lock(grid_mutex); // Bloquear o mutex durante a simulação
-            std::vector<std::vector<entity_t>> new_entity_grid = entity_grid;
-
-            for (uint32_t i = 0; i < NUM_ROWS; ++i) {
-                for (uint32_t j = 0; j < NUM_ROWS; ++j) {
-                    entity_t &current_entity = entity_grid[i][j];
-                    entity_t &new_entity = new_entity_grid[i][j];
-
-                    // Implementar a lógica de comportamento apropriada para cada tipo de entidade
-                    switch (current_entity.type) {
-                        case empty:
-                            // Célula vazia, nenhuma ação necessária
-                            break;
-                        case plant:
-                            // Lógica para plantas (por exemplo, crescimento, reprodução)
-                            if (random_action(PLANT_REPRODUCTION_PROBABILITY)) {
-                                std::vector<pos_t> empty_adjacent_cells;
-                                if (i > 0 && entity_grid[i - 1][j].type == empty) {
-                                    empty_adjacent_cells.push_back({ i - 1, j });
-                                }
-                                if (i < NUM_ROWS - 1 && entity_grid[i + 1][j].type == empty) {
-                                    empty_adjacent_cells.push_back({ i + 1, j });
-                                }
-                                if (j > 0 && entity_grid[i][j - 1].type == empty) {
-                                    empty_adjacent_cells.push_back({ i, j - 1 });
-                                }
-                                if (j < NUM_ROWS - 1 && entity_grid[i][j + 1].type == empty) {
-                                    empty_adjacent_cells.push_back({ i, j + 1 });
-                                }
-
-                                if (!empty_adjacent_cells.empty()) {
-                                    std::uniform_int_distribution<size_t> rand_empty_cell(0, empty_adjacent_cells.size() - 1);
-                                    size_t chosen_index = rand_empty_cell(gen);
-                                    pos_t new_plant_pos = empty_adjacent_cells[chosen_index];
-                                    new_entity_grid[new_plant_pos.i][new_plant_pos.j].type = plant;
-                                }
-                            }
-                            break;
-                        case herbivore:
-                            // Lógica para herbívoros (por exemplo, movimento, alimentação, reprodução)
-                            if (random_action(HERBIVORE_MOVE_PROBABILITY)) {
-                                // Herbívoro se move
-                                int current_i = static_cast<int>(i);
-                                int current_j = static_cast<int>(j);
-                                std::vector<pos_t> possible_moves;
-
-                                if (current_i > 0 && entity_grid[current_i - 1][current_j].type == empty) {
-                                    possible_moves.push_back({current_i - 1, current_j}); // Mover para cima
-                                }
-                                if (current_i < NUM_ROWS - 1 && entity_grid[current_i + 1][current_j].type == empty) {
-                                    possible_moves.push_back({current_i + 1, current_j}); // Mover para baixo
-                                }
-                                if (current_j > 0 && entity_grid[current_i][current_j - 1].type == empty) {
-                                    possible_moves.push_back({current_i, current_j - 1}); // Mover para a esquerda
-                                }
-                                if (current_j < NUM_ROWS - 1 && entity_grid[current_i][current_j + 1].type == empty) {
-                                    possible_moves.push_back({current_i, current_j + 1}); // Mover para a direita
-                                }
-
-                                if (!possible_moves.empty()) {
-                                    int random_index = random_integer(0, possible_moves.size() - 1);
-                                    int new_i = possible_moves[random_index].i;
-                                    int new_j = possible_moves[random_index].j;
-
-                                    new_entity_grid[new_i][new_j] = current_entity;
-                                    new_entity_grid[current_i][current_j].type = empty;
-                                }
-                            }
-
-                            if (random_action(HERBIVORE_EAT_PROBABILITY)) {
-                                // Herbívoro tenta comer uma planta
-                               int current_i = static_cast<int>(i);
-                                int current_j = static_cast<int>(j);
-                                for (int direction = 0; direction < 4; ++direction) {
-                                    int new_i = current_i;
-                                    int new_j = current_j;
-
-                                    switch (direction) {
-                                        case 0:
-                                            if (current_i > 0) {
-                                                new_i = current_i - 1;
-                                            }
-                                            break;
-                                        case 1:
-                                            if (current_i < NUM_ROWS - 1) {
-                                                new_i = current_i + 1;
-                                            }
-                                            break;
-                                        case 2:
-                                            if (current_j > 0) {
-                                                new_j = current_j - 1;
-                                            }
-                                            break;
-                                        case 3:
-                                            if (current_j < NUM_ROWS - 1) {
-                                                new_j = current_j + 1;
-                                            }
-                                            break;
-                                    }
-
-                                    if (entity_grid[new_i][new_j].type == plant) {
-                                        entity_grid[new_i][new_j].type = empty;
-                                        current_entity.energy += 30;
-                                    }
-                                }
-                            }
-
-                            if (random_action(HERBIVORE_REPRODUCTION_PROBABILITY)) {
-                                // Herbívoro tenta se reproduzir
-                                if (current_entity.energy > THRESHOLD_ENERGY_FOR_REPRODUCTION) {
-                                    for (int direction = 0; direction < 4; ++direction) {
-                                        int new_i = i;
-                                        int new_j = j;
-
-                                        switch (direction) {
-                                            case 0:
-                                                if (i > 0) {
-                                                    new_i = i - 1;
-                                                }
-                                                break;
-                                            case 1:
-                                                if (i < NUM_ROWS - 1) {
-                                                    new_i = i + 1;
-                                                }
-                                                break;
-                                            case 2:
-                                                if (j > 0) {
-                                                    new_j = j - 1;
-                                                }
-                                                break;
-                                            case 3:
-                                                if (j < NUM_ROWS - 1) {
-                                                    new_j = j + 1;
-                                                }
-                                                break;
-                                        }
-
-                                        if (entity_grid[new_i][new_j].type == empty) {
-                                            entity_grid[new_i][new_j].type = herbivore;
-                                            entity_grid[new_i][new_j].energy = HERBIVORE_INITIAL_ENERGY;
-                                            entity_grid[new_i][new_j].age = HERBIVORE_INITIAL_AGE;
-                                            current_entity.energy -= 10;
-                                            break;
-                                        }
-                                    }
-                                }
-                            }
-                            break;
-                        case carnivore:
-                            // Lógica para carnívoros (por exemplo, movimento, alimentação, reprodução)
-                            if (random_action(CARNIVORE_MOVE_PROBABILITY)) {
-                                int random_direction = random_integer(0, 3);
-                                int new_i = i;
-                                int new_j = j;
-
-                                switch (random_direction) {
-                                    case 0:
-                                        if (i > 0) {
-                                            new_i = i - 1;
-                                        }
-                                        break;
-                                    case 1:
-                                        if (i < NUM_ROWS - 1) {
-                                            new_i = i + 1;
-                                        }
-                                        break;
-                                    case 2:
-                                        if (j > 0) {
-                                            new_j = j - 1;
-                                        }
-                                        break;
-                                    case 3:
-                                        if (j < NUM_ROWS - 1) {
-                                            new_j = j + 1;
-                                        }
-                                        break;
-                                }
-
-                                if (entity_grid[new_i][new_j].type == herbivore) {
-                                    entity_grid[new_i][new_j] = current_entity;
-                                    entity_grid[i][j].type = empty;
-                                }
-                            }
-
-                            if (random_action(CARNIVORE_EAT_PROBABILITY)) {
-                                int random_direction = random_integer(0, 3);
-                                int new_i = i;
-                                int new_j = j;
-
-                                switch (random_direction) {
-                                    case 0:
-                                        if (i > 0) {
-                                            new_i = i - 1;
-                                        }
-                                        break;
-                                    case 1:
-                                        if (i < NUM_ROWS - 1) {
-                                            new_i = i + 1;
-                                        }
-                                        break;
-                                    case 2:
-                                        if (j > 0) {
-                                            new_j = j - 1;
-                                        }
-                                        break;
-                                    case 3:
-                                        if (j < NUM_ROWS - 1) {
-                                            new_j = j + 1;
-                                        }
-                                        break;
-                                }
-
-                                if (entity_grid[new_i][new_j].type == herbivore) {
-                                    entity_grid[new_i][new_j].type = empty;
-                                    current_entity.energy += 50;
-                                }
-                            }
-
-                            if (random_action(CARNIVORE_REPRODUCTION_PROBABILITY)) {
-                                if (current_entity.energy > THRESHOLD_ENERGY_FOR_REPRODUCTION) {
-                                    for (int direction = 0; direction < 4; ++direction) {
-                                        int new_i = i;
-                                        int new_j = j;
-
-                                        switch (direction) {
-                                            case 0:
-                                                if (i > 0) {
-                                                    new_i = i - 1;
-                                                }
-                                                break;
-                                            case 1:
-                                                if (i < NUM_ROWS - 1) {
-                                                    new_i = i + 1;
-                                                }
-                                                break;
-                                            case 2:
-                                                if (j > 0) {
-                                                    new_j = j - 1;
-                                                }
-                                                break;
-                                            case 3:
-                                                if (j < NUM_ROWS - 1) {
-                                                    new_j = j + 1;
-                                                }
-                                                break;
-                                        }
-
-                                        if (entity_grid[new_i][new_j].type == empty) {
-                                            entity_grid[new_i][new_j].type = carnivore;
-                                            entity_grid[new_i][new_j].energy = CARNIVORE_INITIAL_ENERGY;
-                                            entity_grid[new_i][new_j].age = CARNIVORE_INITIAL_AGE;
-                                            current_entity.energy -= 20;
-                                            break;
-                                        }
-                                    }
-                                }
-                            }
-                            break;
-                    }
+    // Endpoint para ler apenas uma região da última publicação (?x=&y=&w=&h=, coluna e
+    // linha da origem, largura e altura), em qualquer formato e projeção. O custo é
+    // proporcional à região, não à grade, e não bloqueia a simulação.
+    CROW_ROUTE(app, "/region").methods("GET"_method)([](const crow::request &req, crow::response &res) {
+        projection_t projection;
+        if (!readProjection(req, res, projection)) {
+            return;
+        }
+        std::shared_ptr<session_t> session = findSession(req, res);
+        if (!session) {
+            return;
+        }
+        std::shared_ptr<const world_snapshot_t> snapshot = session->view();
+        region_t region;
+        try {
+            region = regionFromQuery(req.url_params.get("x"), req.url_params.get("y"), req.url_params.get("w"), req.url_params.get("h"), snapshot->grid.rows, snapshot->grid.cols);
+        } catch (const std::invalid_argument &error) {
+            res.code = 400;
+            res.body = error.what();
+            res.end();
+            return;
+        }
 
-                    // Atualizar a idade e energia da entidade
-                    current_entity.age++;
-                    current_entity.energy--;
+        frame_key_t key;
+        key.version = snapshot->header.version;
+        key.format = req.get_header_value("Accept").find(FRAME_CONTENT_TYPE) != std::string::npos ? binary_format : json_format;
+        key.projection = projection.key();
+        key.region = region.key();
+
+        const std::string etag = frameETag(key);
+        res.set_header("Content-Type", key.format == binary_format ? FRAME_CONTENT_TYPE : "application/json");
+        res.set_header("X-Version", std::to_string(key.version));
+        res.set_header("X-Region", key.region);
+        res.set_header("ETag", etag);
+        if (req.get_header_value("If-None-Match") == etag) {
+            res.code = 304;
+            res.end();
+            return;
+        }
 
-                    if (current_entity.energy <= 0) {
-                        // A entidade morre se sua energia for esgotada
-                        new_entity_grid[i][j] = { empty, 0, 0 };
-                    }
+        res.body = *session->frame_cache.get(key, [&]() {
+            frame_header_t header = snapshot->header;
+            header.region = true;
+            header.x = region.x;
+            header.y = region.y;
+            return encodeFrame(extract_region(snapshot->grid, region), header, key.format, {}, projection);
+        });
+        res.end();
+    });
+
+    // Endpoint para ler um ladrilho de mapa da última publicação, como PNG de 256 x 256
+    // pixels. No zoom 0 um ladrilho cobre o mundo inteiro e cada zoom seguinte divide o
+    // lado dos pixels pela metade; os ladrilhos são guardados no cache por publicação.
+    CROW_ROUTE(app, "/tiles/<uint>/<uint>/<uint>").methods("GET"_method)([](const crow::request &req, crow::response &res, uint64_t z, uint64_t x, uint64_t y) {
+        std::shared_ptr<session_t> session = findSession(req, res);
+        if (!session) {
+            return;
+        }
+        std::shared_ptr<const world_snapshot_t> snapshot = session->view();
+        const uint32_t native = tile_native_zoom(snapshot->grid);
+        if (z > native + TILE_MAXIMUM_MAGNIFICATION || x >= (1ull << z) || y >= (1ull << z)) {
+            res.code = 400;
+            res.body = "Ladrilho fora do mundo (zoom máximo " + std::to_string(native + TILE_MAXIMUM_MAGNIFICATION) + ")";
+            res.end();
+            return;
+        }
+
+        frame_key_t key;
+        key.version = snapshot->header.version;
+        key.format = png_format;
+        key.region = "tile," + std::to_string(z) + "," + std::to_string(x) + "," + std::to_string(y);
+
+        const std::string etag = frameETag(key);
+        res.set_header("Content-Type", "image/png");
+        res.set_header("X-Version", std::to_string(key.version));
+        res.set_header("ETag", etag);
+        if (req.get_header_value("If-None-Match") == etag) {
+            res.code = 304;
+            res.end();
+            return;
+        }
+
+        bool hit = false;
+        res.body = *session->frame_cache.get(key, [&]() {
+            return render_tile_png(*snapshot, static_cast<uint32_t>(z), static_cast<uint32_t>(x), static_cast<uint32_t>(y));
+        }, &hit);
+        res.set_header("X-Cache", hit ? "hit" : "miss");
+        res.end();
+    });
+
+    // Endpoint para consultar a pirâmide de resumos da última publicação: no nível
+    // ?level=k, cada bloco resume 2^k x 2^k células. ?x=&y=&w=&h= (em blocos) limita a
+    // consulta a um retângulo; sem eles, retorna o nível inteiro. Para cada bloco, em
+    // ordem de linha, retorna as contagens de cada espécie e a energia média.
+    CROW_ROUTE(app, "/pyramid").methods("GET"_method)([](const crow::request &req, crow::response &res) {
+        std::shared_ptr<session_t> session = findSession(req, res);
+        if (!session) {
+            return;
+        }
+        std::shared_ptr<const world_snapshot_t> snapshot = session->view();
+        const pyramid_t &pyramid = snapshot->pyramid();
+
+        const char *level_parameter = req.url_params.get("level");
+        uint32_t level = level_parameter ? std::strtoul(level_parameter, nullptr, 10) : pyramid.top_level();
+        if (level < PYRAMID_BASE_LEVEL || level > pyramid.top_level()) {
+            res.code = 400;
+            res.body = "O nível deve estar entre " + std::to_string(PYRAMID_BASE_LEVEL) + " e " + std::to_string(pyramid.top_level());
+            res.end();
+            return;
+        }
+        const pyramid_level_t &blocks = pyramid.level(level);
+
+        region_t region;
+        region.w = blocks.cols;
+        region.h = blocks.rows;
+        try {
+            if (req.url_params.get("x") || req.url_params.get("y") || req.url_params.get("w") || req.url_params.get("h")) {
+                region = regionFromQuery(req.url_params.get("x"), req.url_params.get("y"), req.url_params.get("w"), req.url_params.get("h"), blocks.rows, blocks.cols);
+            }
+        } catch (const std::invalid_argument &error) {
+            res.code = 400;
+            res.body = error.what();
+            res.end();
+            return;
+        }
+
+        nlohmann::json plants = nlohmann::json::array(), herbivores = nlohmann::json::array(), carnivores = nlohmann::json::array(), energy = nlohmann::json::array();
+        for (uint32_t i = region.y; i < region.y + region.h; ++i) {
+            for (uint32_t j = region.x; j < region.x + region.w; ++j) {
+                const block_summary_t &block = blocks.blocks[static_cast<size_t>(i) * blocks.cols + j];
+                plants.push_back(block.plants);
+                herbivores.push_back(block.herbivores);
+                carnivores.push_back(block.carnivores);
+                energy.push_back(block.occupied() ? static_cast<double>(block.energy) / block.occupied() : 0.0);
+            }
+        }
+
+        nlohmann::json result = {
+            { "version", snapshot->header.version },
+            { "level", level },
+            { "block", 1u << level },
+            { "rows", blocks.rows },
+            { "cols", blocks.cols },
+            { "x", region.x },
+            { "y", region.y },
+            { "w", region.w },
+            { "h", region.h },
+            { "plants", plants },
+            { "herbivores", herbivores },
+            { "carnivores", carnivores },
+            { "energy", energy }
+        };
+        res.set_header("Content-Type", "application/json");
+        res.body = result.dump();
+        res.end();
+    });
+
+    // Canal WebSocket que recebe cada publicação da grade de uma sessão (quadros binários
+    // por padrão). Mensagens do cliente: "session <id>" escolhe a sessão acompanhada,
+    // "ack" confirma um quadro processado, "next" avança a simulação como
+    // /next-iteration, "budget <ms>" define o orçamento de um quadro, "json" e "binary"
+    // escolhem o formato.
+    CROW_ROUTE(app, "/ws").websocket()
+        .onopen([](crow::websocket::connection &connection) {
+            connection.userdata(new std::shared_ptr<session_t>());
+        })
+        .onclose([](crow::websocket::connection &connection, const std::string &) {
+            auto *session = static_cast<std::shared_ptr<session_t> *>(connection.userdata());
+            if (*session) {
+                (*session)->push_hub.remove(&connection);
+            }
+            delete session;
+        })
+        .onmessage([](crow::websocket::connection &connection, const std::string &message, bool) {
+            std::shared_ptr<session_t> &session = *static_cast<std::shared_ptr<session_t> *>(connection.userdata());
+            if (message.compare(0, 8, "session ") == 0) {
+                if (session) {
+                    session->push_hub.remove(&connection);
                 }
+                session = sessions.find(std::strtoull(message.c_str() + 8, nullptr, 10));
+                if (!session) {
+                    connection.send_text("Sessão não encontrada");
+                    return;
+                }
+                // Com clientes conectados, a sessão fica em memória
+                session->run([&]() {
+                    session->push_hub.add(&connection, [&connection](const std::string &message, bool binary) {
+                        if (binary) {
+                            connection.send_binary(message);
+                        } else {
+                            connection.send_text(message);
+                        }
+                    });
+                    std::lock_guard<std::mutex> lock(session->mutex);
+                    session->push_hub.flush(&connection, session->grid, session->change_log, session->current_header());
+                });
+            } else if (!session) {
+                return;
+            } else if (message == "next") {
+                const bool accepted = session->pacer.slice_iterations() ? session->advance_in_slices(session->pacer.budget()) > 0 : session->run_request([&]() { session->advance(); });
+                if (!accepted) {
+                    connection.send_text("Sessão ocupada: pedidos demais esperando");
+                    return;
+                }
+                speculation.schedule(session);
+            } else if (message.compare(0, 7, "budget ") == 0) {
+                double milliseconds = 0;
+                if (!parse_frame_budget(message.c_str() + 7, milliseconds)) {
+                    connection.send_text("Orçamento de quadro inválido");
+                    return;
+                }
+                session->pacer.set_budget(milliseconds);
+            } else if (message == "ack") {
+                std::lock_guard<std::mutex> lock(session->mutex);
+                session->push_hub.ack(&connection, session->grid, session->change_log, session->current_header());
+            } else if (message == "json" || message == "binary") {
+                session->push_hub.set_binary(&connection, message == "binary");
+                std::lock_guard<std::mutex> lock(session->mutex);
+                session->push_hub.flush(&connection, session->grid, session->change_log, session->current_header());
             }
+        });
+
+    // Endpoint para consultar as regras em vigor
+    CROW_ROUTE(app, "/rules").methods("GET"_method)([](const crow::request &req, crow::response &res) {
+        std::shared_ptr<session_t> session = findSession(req, res);
+        if (!session) {
+            return;
+        }
+        res.body = rulesToJson(*std::atomic_load(&session->rules)).dump();
+        res.end();
+    });
+
+    // Endpoint para atualizar as regras do mundo em execução; os campos enviados substituem
+    // os atuais e o resultado passa a valer na próxima iteração
+    CROW_ROUTE(app, "/rules").methods("POST"_method)([](crow::request &req, crow::response &res) {
+        std::shared_ptr<session_t> session = findSession(req, res);
+        if (!session) {
+            return;
+        }
+        std::shared_ptr<const rules_t> current = std::atomic_load(&session->rules);
+        std::shared_ptr<const rules_t> updated;
+        try {
+            nlohmann::json patch = nlohmann::json::parse(req.body);
+            do {
+                updated = std::make_shared<const rules_t>(rulesFromJson(patch, *current));
+            } while (!std::atomic_compare_exchange_weak(&session->rules, &current, updated));
+        } catch (const std::exception &error) {
+            res.code = 400;
+            res.body = error.what();
+            res.end();
+            return;
+        }
+
+        res.body = rulesToJson(*updated).dump();
+        res.end();
+    });
+
+    // Endpoint para listar as sessões abertas
+    CROW_ROUTE(app, "/sessions").methods("GET"_method)([]() {
+        nlohmann::json result = nlohmann::json::array();
+        for (const std::shared_ptr<session_t> &session : sessions.list()) {
+            result.push_back(session->describe());
+        }
+        return result.dump();
+    });
+
+    // Endpoint para encerrar uma sessão
+    CROW_ROUTE(app, "/sessions/<uint>").methods("DELETE"_method)([](uint64_t id) {
+        if (!sessions.remove(id)) {
+            return crow::response(404, "Sessão não encontrada");
+        }
+        return crow::response(204);
+    });
+
+    // Endpoint para ajustar o escalonamento de uma sessão: { "weight": 2 } dá à sessão o
+    // dobro do tempo de CPU de uma sessão de peso 1 quando o motor está disputado
+    CROW_ROUTE(app, "/sessions/<uint>").methods("POST"_method)([](const crow::request &req, uint64_t id) {
+        std::shared_ptr<session_t> session = sessions.find(id);
+        if (!session) {
+            return crow::response(404, "Sessão não encontrada");
+        }
+        double weight = 0;
+        try {
+            weight = nlohmann::json::parse(req.body).at("weight").get<double>();
+        } catch (const std::exception &error) {
+            return crow::response(400, error.what());
+        }
+        if (!(weight >= SCHEDULER_MINIMUM_WEIGHT && weight <= SCHEDULER_MAXIMUM_WEIGHT)) {
+            return crow::response(400, "Peso inválido");
+        }
+        session->account.weight = weight;
+        return crow::response(session->describe().dump());
+    });
+
+    // Endpoint para simular um ensemble de mundos independentes e agregar a população
+    CROW_ROUTE(app, "/ensemble").methods("POST"_method)([](crow::request &req, crow::response &res) {
+        // Analisar o corpo da solicitação JSON
+        nlohmann::json request_body;
+        uint32_t num_plants, num_herbivores, num_carnivores, replicates, iterations;
+        uint64_t seed;
+        try {
+            request_body = nlohmann::json::parse(req.body);
+            num_plants = request_body.at("plants").get<uint32_t>();
+            num_herbivores = request_body.at("herbivores").get<uint32_t>();
+            num_carnivores = request_body.at("carnivores").get<uint32_t>();
+            replicates = request_body.value("replicates", 100u);
+            iterations = request_body.value("iterations", 100u);
+            seed = request_body.value("seed", (uint64_t)std::random_device{}());
+        } catch (const std::exception &error) {
+            res.code = 400;
+            res.body = error.what();
+            res.end();
+            return;
+        }
+
+        // Validar a solicitação
+        if ((uint64_t)num_plants + num_herbivores + num_carnivores > NUM_ROWS * NUM_ROWS) {
+            res.code = 400;
+            res.body = "Muitas entidades";
+            res.end();
+            return;
+        }
+        if (replicates == 0 || replicates > MAXIMUM_ENSEMBLE_REPLICATES || iterations > MAXIMUM_ENSEMBLE_ITERATIONS) {
+            res.code = 400;
+            res.body = "Número de réplicas ou iterações inválido";
+            res.end();
+            return;
+        }
+        if ((uint64_t)replicates * std::max(iterations, 1u) * NUM_ROWS * NUM_ROWS > MAXIMUM_ENSEMBLE_CELL_STEPS) {
+            res.code = 400;
+            res.body = "Ensemble grande demais: réplicas × iterações × células acima do limite";
+            res.end();
+            return;
+        }
 
-            // Atualizar a grade de entidades com a cópia temporária
-            entity_grid = new_entity_grid;
+        rules_t rules;
+        try {
+            rules = rulesFromJson(request_body.value("rules", nlohmann::json::object()));
+        } catch (const std::invalid_argument &error) {
+            res.code = 400;
+            res.body = error.what();
+            res.end();
+            return;
         }
 
-        // Retorne a representação JSON da grade de entidades
-        nlohmann::json json_grid = entityGridToJson(entity_grid);
-        return json_grid.dump();
+        // Avançar todos os mundos em lockstep, sem tocar nas sessões
+        ensemble_t ensemble = ensemble_create(NUM_ROWS, NUM_ROWS, replicates, seed);
+        ensemble_populate(ensemble, rules, num_plants, num_herbivores, num_carnivores);
+
+        ensemble_series_t plants, herbivores, carnivores;
+        ensemble_run(ensemble, rules, iterations, plants, herbivores, carnivores);
+
+        // Retornar a série temporal agregada da população
+        nlohmann::json result = {
+            { "replicates", replicates },
+            { "iterations", iterations },
+            { "seed", seed },
+            { "plants", { { "mean", plants.mean }, { "stddev", plants.stddev } } },
+            { "herbivores", { { "mean", herbivores.mean }, { "stddev", herbivores.stddev } } },
+            { "carnivores", { { "mean", carnivores.mean }, { "stddev", carnivores.stddev } } }
+        };
+        res.body = result.dump();
+        res.end();
+    });
+
+    // Endpoint para iniciar uma varredura de parâmetros
+    CROW_ROUTE(app, "/sweeps").methods("POST"_method)([](crow::request &req, crow::response &res) {
+        sweep_spec_t spec;
+        try {
+            spec = sweepSpecFromJson(nlohmann::json::parse(req.body));
+        } catch (const std::exception &error) {
+            res.code = 400;
+            res.body = error.what();
+            res.end();
+            return;
+        }
+
+        std::shared_ptr<sweep_job_t> job = sweeps.submit(spec);
+        if (!job) {
+            res.code = 429;
+            res.body = "Muitas varreduras em execução";
+            res.end();
+            return;
+        }
+        nlohmann::json result = { { "id", job->id }, { "runs", job->total } };
+        res.code = 202;
+        res.body = result.dump();
+        res.end();
+    });
+
+    // Endpoint para acompanhar uma varredura: retorna os resumos a partir de ?from=, esperando até ?wait= ms
+    CROW_ROUTE(app, "/sweeps/<uint>").methods("GET"_method)([](const crow::request &req, uint64_t id) {
+        std::shared_ptr<sweep_job_t> job = sweeps.find(id);
+        if (!job) {
+            return crow::response(404, "Varredura não encontrada");
+        }
+
+        uint64_t from = 0, wait_ms = 0;
+        if ((req.url_params.get("from") && !parseUnsigned(req.url_params.get("from"), from)) || (req.url_params.get("wait") && !parseUnsigned(req.url_params.get("wait"), wait_ms))) {
+            return crow::response(400, "from e wait devem ser inteiros não negativos");
+        }
+        return crow::response(sweeps.poll(*job, from, std::min<uint64_t>(wait_ms, 30000)).dump());
     });
 
-    app.port(8080).run(); // Use port 8081 instead of 8080
+    // Endpoint para cancelar uma varredura
+    CROW_ROUTE(app, "/sweeps/<uint>").methods("DELETE"_method)([](uint64_t id) {
+        std::shared_ptr<sweep_job_t> job = sweeps.find(id);
+        if (!job) {
+            return crow::response(404, "Varredura não encontrada");
+        }
+
+        job->cancelled = true;
+        return crow::response(204);
+    });
+
+    // Endpoint para iniciar um job longo sobre uma sessão: { "session": id, "ticks": n,
+    // "stop": { "extinction": true, "steady_window": 100 } }. Retorna o id do job.
+    CROW_ROUTE(app, "/jobs").methods("POST"_method)([](crow::request &req, crow::response &res) {
+        job_spec_t spec;
+        uint64_t session_id = 0;
+        try {
+            nlohmann::json request_body = nlohmann::json::parse(req.body);
+            session_id = request_body.value("session", (uint64_t)0);
+            spec = jobSpecFromJson(request_body);
+        } catch (const std::exception &error) {
+            res.code = 400;
+            res.body = error.what();
+            res.end();
+            return;
+        }
+
+        std::shared_ptr<session_t> session = sessions.find(session_id);
+        if (!session) {
+            res.code = 404;
+            res.body = "Sessão não encontrada";
+            res.end();
+            return;
+        }
+
+        std::shared_ptr<job_t> job = jobs.submit(session, spec);
+        if (!job) {
+            res.code = 429;
+            res.body = "Muitos jobs em execução";
+            res.end();
+            return;
+        }
+        nlohmann::json result = { { "id", job->id } };
+        res.code = 202;
+        res.body = result.dump();
+        res.end();
+    });
+
+    // Endpoint para acompanhar um job: iterações feitas, iterações por segundo e tempo restante
+    CROW_ROUTE(app, "/jobs/<uint>").methods("GET"_method)([](uint64_t id) {
+        std::shared_ptr<job_t> job = jobs.find(id);
+        if (!job) {
+            return crow::response(404, "Job não encontrado");
+        }
+        return crow::response(jobToJson(*job).dump());
+    });
+
+    // Endpoint para cancelar um job (ele para ao fim da fatia atual)
+    CROW_ROUTE(app, "/jobs/<uint>").methods("DELETE"_method)([](uint64_t id) {
+        std::shared_ptr<job_t> job = jobs.find(id);
+        if (!job) {
+            return crow::response(404, "Job não encontrado");
+        }
+
+        job->cancelled = true;
+        return crow::response(204);
+    });
+
+    // Número de slots de CPU do escalonador do motor (ECOSIM_ENGINE_SLOTS; por padrão, um
+    // por núcleo)
+    if (const char *slots = std::getenv("ECOSIM_ENGINE_SLOTS")) {
+        engine_scheduler().set_slots(std::strtoul(slots, nullptr, 10));
+    }
+
+    // Orçamento de memória das sessões (ECOSIM_MEMORY_BUDGET_MB), diretório onde as sessões
+    // despejadas são gravadas (ECOSIM_SPILL_DIR) e número máximo de sessões abertas
+    // (ECOSIM_MAXIMUM_SESSIONS)
+    const char *budget = std::getenv("ECOSIM_MEMORY_BUDGET_MB");
+    const char *spill_directory = std::getenv("ECOSIM_SPILL_DIR");
+    const char *maximum_sessions = std::getenv("ECOSIM_MAXIMUM_SESSIONS");
+
+    // Número de threads do servidor (ECOSIM_THREADS; por padrão, uma por núcleo). Pedidos
+    // para sessões diferentes rodam em paralelo; os de uma mesma sessão passam pelo seu
+    // strand, onde no máximo metade das threads pode esperar a vez.
+    const char *threads = std::getenv("ECOSIM_THREADS");
+    unsigned concurrency = threads ? std::strtoul(threads, nullptr, 10) : std::thread::hardware_concurrency();
+    sessions.configure(budget ? size_t(std::strtoull(budget, nullptr, 10)) << 20 : SESSION_DEFAULT_MEMORY_BUDGET,
+                       spill_directory ? spill_directory : (std::filesystem::temp_directory_path() / "ecosim-sessions").string(),
+                       maximum_sessions ? std::strtoull(maximum_sessions, nullptr, 10) : SESSION_DEFAULT_MAXIMUM_COUNT,
+                       std::max(1u, concurrency / 2));
+    app.port(8080).concurrency(static_cast<uint16_t>(std::min(concurrency, 1024u))).run(); // Use port 8081 instead of 8080
 
     return 0;
 }
@@ -3,6 +3,7 @@
 
 #include "crow_all.h"
 #include "json.hpp"
+#include "placement.h"
 #include <random>
 
 static const uint32_t NUM_ROWS = 15;
@@ -116,16 +117,18 @@ void simulate_random_actions() {
 // Grid that contains the entities
 static std::vector<std::vector<entity_t>> entity_grid;
 
+// Sorteador das células ainda vazias, reiniciado a cada /start-simulation
+static cell_sampler_t cell_sampler(NUM_ROWS * NUM_ROWS, 0);
+static std::mt19937 placement_gen(std::random_device{}());
+
 
         // Função para criar as plantas aleatoriamente no grid
         void createPlants(int numPlants) {
             for (int i = 0; i < numPlants; ++i) {
-                int row, col;
-                // Gere posições aleatórias até encontrar uma célula vazia (empty)
-                do {
-                    row = random_integer(0, NUM_ROWS - 1);
-                    col = random_integer(0, NUM_ROWS - 1);
-                } while (entity_grid[row][col].type != empty);
+                // Sorteie uma célula ainda vazia (empty), sem tentativas repetidas
+                uint64_t cell = cell_sampler.next(placement_gen);
+                uint32_t row = cell / NUM_ROWS;
+                uint32_t col = cell % NUM_ROWS;
                 
                 // Defina a célula como uma planta
                 entity_grid[row][col].type = plant;
@@ -135,14 +138,12 @@ static std::vector<std::vector<entity_t>> entity_grid;
         // Função para criar herbivoros aleatoriamente no grid
         void createHerbivores(int numHerbivores) {
             for (int i = 0; i < numHerbivores; ++i) {
-                int row, col;
-                // Gere posições aleatórias até encontrar uma célula vazia (empty)
-                do {
-                    row = random_integer(0, NUM_ROWS - 1);
-                    col = random_integer(0, NUM_ROWS - 1);
-                } while (entity_grid[row][col].type != empty);
+                // Sorteie uma célula ainda vazia (empty), sem tentativas repetidas
+                uint64_t cell = cell_sampler.next(placement_gen);
+                uint32_t row = cell / NUM_ROWS;
+                uint32_t col = cell % NUM_ROWS;
                 
-                // Defina a célula como uma planta
+                // Defina a célula como um herbívoro
                 entity_grid[row][col].type = herbivore;
                 entity_grid[row][col].energy = HERBIVORE_INITIAL_ENERGY;
                 entity_grid[row][col].age = HERBIVORE_INITIAL_AGE;
@@ -152,14 +153,12 @@ static std::vector<std::vector<entity_t>> entity_grid;
         // Função para criar carnivoros aleatoriamente no grid
         void createCarnivores(int numCarnivores) {
             for (int i = 0; i < numCarnivores; ++i) {
-                int row, col;
-                // Gere posições aleatórias até encontrar uma célula vazia (empty)
-                do {
-                    row = random_integer(0, NUM_ROWS - 1);
-                    col = random_integer(0, NUM_ROWS - 1);
-                } while (entity_grid[row][col].type != empty);
+                // Sorteie uma célula ainda vazia (empty), sem tentativas repetidas
+                uint64_t cell = cell_sampler.next(placement_gen);
+                uint32_t row = cell / NUM_ROWS;
+                uint32_t col = cell % NUM_ROWS;
                 
-                // Defina a célula como uma planta
+                // Defina a célula como um carnívoro
                 entity_grid[row][col].type = carnivore;
                 entity_grid[row][col].energy = CARNIVORE_INITIAL_ENERGY;
                 entity_grid[row][col].age = CARNIVORE_INITIAL_AGE;
@@ -206,6 +205,7 @@ int main()
         uint32_t numCarnivores = (uint32_t)request_body["carnivores"];
 
         // Chame as funções para criar as entidades com base nos valores fornecidos
+        cell_sampler = cell_sampler_t(NUM_ROWS * NUM_ROWS, numPlants + numHerbivores + numCarnivores);
         createPlants(numPlants);
         createHerbivores(numHerbivores);
         createCarnivores(numCarnivores);
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+// Controle do número de iterações por quadro entregue.
+//
+// O custo de uma iteração depende do tamanho e da densidade do mundo, então um número fixo
+// de iterações por quadro é lento demais em mundos grandes e rápido demais nos pequenos. O
+// pacer mede o custo de cada lote simulado (média móvel exponencial do tempo por iteração)
+// e escolhe quantas iterações cabem no orçamento de tempo de um quadro. O orçamento cobre
+// a simulação; a codificação do quadro vem depois.
+
+// Orçamento padrão de um quadro, em milissegundos, e limites aceitos
+static const double PACER_DEFAULT_BUDGET_MS = 16;
+static const double PACER_MINIMUM_BUDGET_MS = 1;
+static const double PACER_MAXIMUM_BUDGET_MS = 60000;
+
+// Número máximo de iterações por quadro
+static const unsigned PACER_MAXIMUM_ITERATIONS = 100000;
+
+// Peso de cada nova medida na média do custo por iteração
+static const double PACER_SMOOTHING = 0.25;
+
+// Função para ler um orçamento de quadro, em milissegundos; retorna false se o texto não é
+// um número finito do começo ao fim (por exemplo, "nan", "inf" ou "16ms")
+inline bool parse_frame_budget(const char *text, double &milliseconds) {
+    char *end = nullptr;
+    milliseconds = std::strtod(text, &end);
+    return end != text && *end == '\0' && std::isfinite(milliseconds);
+}
+
+// Defina o controlador de iterações por quadro de uma sessão. As medidas são feitas no
+// strand da sessão; os valores podem ser lidos de qualquer thread.
+class frame_pacer_t {
+public:
+    // Definir o orçamento de um quadro, em milissegundos (limitado aos valores aceitos; NaN
+    // é ignorado, já que std::clamp o deixaria passar)
+    void set_budget(double milliseconds) {
+        if (std::isnan(milliseconds)) {
+            return;
+        }
+        budget_ms_ = std::clamp(milliseconds, PACER_MINIMUM_BUDGET_MS, PACER_MAXIMUM_BUDGET_MS);
+    }
+
+    double budget_ms() const {
+        return budget_ms_;
+    }
+
+    std::chrono::steady_clock::duration budget() const {
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(budget_ms_));
+    }
+
+    // Registrar que iterations iterações levaram seconds segundos
+    void measure(uint64_t iterations, double seconds) {
+        if (iterations == 0) {
+            return;
+        }
+        const double sample = seconds / iterations;
+        const double cost = tick_seconds_;
+        tick_seconds_ = cost > 0 ? cost + PACER_SMOOTHING * (sample - cost) : sample;
+    }
+
+    // Custo médio estimado de uma iteração, em segundos (0 antes da primeira medida)
+    double tick_seconds() const {
+        return tick_seconds_;
+    }
+
+    // Se as iterações devem ser simuladas em fatias do tamanho do orçamento: antes da
+    // primeira medida (o mundo pode ser enorme) ou quando uma única iteração o estoura
+    bool slice_iterations() const {
+        const double cost = tick_seconds_;
+        return cost <= 0 || cost * 1000 > budget_ms_;
+    }
+
+    // Número de iterações do próximo quadro. Antes da primeira medida, uma só iteração,
+    // de modo que mesmo o primeiro quadro de um mundo enorme não estoura o orçamento.
+    unsigned iterations() const {
+        const double cost = tick_seconds_;
+        if (cost <= 0) {
+            return 1;
+        }
+        const double fitting = std::floor(budget_ms_ / 1000 / cost);
+        return static_cast<unsigned>(std::clamp(fitting, 1.0, double(PACER_MAXIMUM_ITERATIONS)));
+    }
+
+private:
+    std::atomic<double> budget_ms_{ PACER_DEFAULT_BUDGET_MS };
+    std::atomic<double> tick_seconds_{ 0 };
+};
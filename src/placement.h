@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Sorteador de células distintas em ordem aleatória.
+//
+// Implementa um Fisher-Yates parcial sobre o arranjo virtual [0, 1, ..., n - 1]:
+// apenas as posições que já foram trocadas ficam guardadas, em uma tabela hash de
+// endereçamento aberto. Cada sorteio custa O(1) esperado, independentemente do
+// tamanho da grade e de quantas células já estão ocupadas, e nunca repete uma célula.
+// Quando os sorteios cobrem boa parte da grade, o arranjo é materializado de uma vez,
+// o que continua linear no número de entidades e evita a tabela.
+class cell_sampler_t {
+public:
+    cell_sampler_t(uint64_t num_cells, uint64_t expected_draws) : num_cells_(num_cells) {
+        if (expected_draws * DENSE_FRACTION >= num_cells && num_cells <= UINT32_MAX) {
+            dense_.resize(num_cells);
+            for (uint64_t cell = 0; cell < num_cells; ++cell) {
+                dense_[cell] = cell;
+            }
+            return;
+        }
+        uint64_t capacity = 16;
+        while (capacity < expected_draws * 2) {
+            capacity <<= 1;
+        }
+        slots_.assign(capacity, { EMPTY_KEY, 0 });
+    }
+
+    // Quantidade de células ainda não sorteadas
+    uint64_t remaining() const {
+        return num_cells_ - taken_;
+    }
+
+    // Sortear a próxima célula usando um gerador da biblioteca padrão
+    template <typename Generator>
+    uint64_t next(Generator &gen) {
+        if (remaining() == 0) {
+            throw std::out_of_range("Não há mais células livres");
+        }
+        std::uniform_int_distribution<uint64_t> distribution(0, remaining() - 1);
+        return select(distribution(gen));
+    }
+
+    // Sortear a próxima célula a partir de um deslocamento uniforme em [0, remaining())
+    uint64_t select(uint64_t offset) {
+        if (offset >= remaining()) {
+            throw std::out_of_range("Não há mais células livres");
+        }
+        const uint64_t j = taken_ + offset;
+        if (!dense_.empty()) {
+            std::swap(dense_[taken_], dense_[j]);
+            return dense_[taken_++];
+        }
+        const uint64_t chosen = lookup(j);
+        if (j != taken_) {
+            store(j, lookup(taken_));
+        }
+        ++taken_;
+        return chosen;
+    }
+
+private:
+    static constexpr uint64_t EMPTY_KEY = ~0ull;
+    static constexpr uint64_t DENSE_FRACTION = 8;
+
+    struct slot_t {
+        uint64_t key;
+        uint64_t value;
+    };
+
+    static uint64_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    // Valor na posição do arranjo virtual (a própria posição se nunca foi trocada)
+    uint64_t lookup(uint64_t key) const {
+        const uint64_t mask = slots_.size() - 1;
+        for (uint64_t slot = hash(key) & mask;; slot = (slot + 1) & mask) {
+            if (slots_[slot].key == key) {
+                return slots_[slot].value;
+            }
+            if (slots_[slot].key == EMPTY_KEY) {
+                return key;
+            }
+        }
+    }
+
+    void store(uint64_t key, uint64_t value) {
+        if ((used_ + 1) * 2 > slots_.size()) {
+            grow();
+        }
+        const uint64_t mask = slots_.size() - 1;
+        uint64_t slot = hash(key) & mask;
+        while (slots_[slot].key != EMPTY_KEY && slots_[slot].key != key) {
+            slot = (slot + 1) & mask;
+        }
+        used_ += slots_[slot].key == EMPTY_KEY;
+        slots_[slot] = { key, value };
+    }
+
+    void grow() {
+        std::vector<slot_t> slots(slots_.size() * 2, { EMPTY_KEY, 0 });
+        slots.swap(slots_);
+        used_ = 0;
+        for (const slot_t &slot : slots) {
+            if (slot.key != EMPTY_KEY) {
+                store(slot.key, slot.value);
+            }
+        }
+    }
+
+    uint64_t num_cells_;
+    uint64_t taken_ = 0;
+    uint64_t used_ = 0;
+    std::vector<slot_t> slots_;
+    std::vector<uint32_t> dense_;
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Codificador PNG autocontido (imagens RGB de 8 bits).
+//
+// Cada linha recebe o filtro PNG que deixa os bytes mais próximos de zero (None, Sub
+// ou Up), e o resultado é comprimido em um único bloco deflate com códigos de Huffman
+// fixos, usando apenas repetições à distância 1. Isso basta para as imagens da
+// simulação, que têm grandes áreas de cor uniforme, sem depender de zlib.
+
+// Tabela de CRC-32 usada pelos blocos PNG
+inline const uint32_t *png_crc_table() {
+    static const std::vector<uint32_t> table = []() {
+        std::vector<uint32_t> table(256);
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return table;
+    }();
+    return table.data();
+}
+
+// Defina a escrita de bits na ordem do deflate (bit menos significativo primeiro)
+class deflate_bits_t {
+public:
+    explicit deflate_bits_t(std::string &out) : out_(out) {}
+
+    void put(uint32_t value, int count) {
+        bits_ |= static_cast<uint64_t>(value) << count_;
+        count_ += count;
+        while (count_ >= 8) {
+            out_ += static_cast<char>(bits_ & 0xFF);
+            bits_ >>= 8;
+            count_ -= 8;
+        }
+    }
+
+    // Escrever um código de Huffman (definido do bit mais significativo para o menos)
+    void put_code(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int bit = 0; bit < length; ++bit) {
+            reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+        }
+        put(reversed, length);
+    }
+
+    void flush() {
+        if (count_ > 0) {
+            out_ += static_cast<char>(bits_ & 0xFF);
+        }
+        bits_ = 0;
+        count_ = 0;
+    }
+
+private:
+    std::string &out_;
+    uint64_t bits_ = 0;
+    int count_ = 0;
+};
+
+// Função para escrever um símbolo literal/comprimento com o código de Huffman fixo
+inline void put_fixed_symbol(deflate_bits_t &bits, uint32_t symbol) {
+    if (symbol < 144) {
+        bits.put_code(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        bits.put_code(0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        bits.put_code(symbol - 256, 7);
+    } else {
+        bits.put_code(0xC0 + symbol - 280, 8);
+    }
+}
+
+// Função para escrever uma repetição de length bytes (3 a 258) à distância 1
+inline void put_fixed_repeat(deflate_bits_t &bits, uint32_t length) {
+    static const uint16_t base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    int code = 28;
+    while (base[code] > length) {
+        --code;
+    }
+    put_fixed_symbol(bits, 257 + code);
+    bits.put(length - base[code], extra[code]);
+    bits.put_code(0, 5); // código de distância 0 (distância 1), sem bits extras
+}
+
+// Função para comprimir os dados no formato zlib (um bloco deflate com Huffman fixo)
+inline std::string zlib_compress(const std::vector<uint8_t> &data) {
+    std::string out;
+    out += static_cast<char>(0x78);
+    out += static_cast<char>(0x01);
+
+    deflate_bits_t bits(out);
+    bits.put(1, 1); // último bloco
+    bits.put(1, 2); // Huffman fixo
+    size_t position = 0;
+    while (position < data.size()) {
+        size_t run = 0;
+        if (position > 0) {
+            while (run < 258 && position + run < data.size() && data[position + run] == data[position - 1]) {
+                ++run;
+            }
+        }
+        if (run >= 3) {
+            put_fixed_repeat(bits, static_cast<uint32_t>(run));
+            position += run;
+        } else {
+            put_fixed_symbol(bits, data[position]);
+            ++position;
+        }
+    }
+    put_fixed_symbol(bits, 256); // fim do bloco
+    bits.flush();
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : data) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    const uint32_t adler = (b << 16) | a;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out += static_cast<char>((adler >> shift) & 0xFF);
+    }
+    return out;
+}
+
+// Função para escrever um bloco PNG (tamanho, tipo, dados e CRC)
+inline void put_png_chunk(std::string &png, const char *type, const std::string &data) {
+    auto put_u32 = [&png](uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            png += static_cast<char>((value >> shift) & 0xFF);
+        }
+    };
+    put_u32(static_cast<uint32_t>(data.size()));
+    const size_t start = png.size();
+    png.append(type, 4);
+    png += data;
+
+    const uint32_t *table = png_crc_table();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t k = start; k < png.size(); ++k) {
+        crc = table[(crc ^ static_cast<uint8_t>(png[k])) & 0xFF] ^ (crc >> 8);
+    }
+    put_u32(crc ^ 0xFFFFFFFFu);
+}
+
+// Função para codificar uma imagem RGB (3 bytes por pixel, em ordem de linha) em PNG
+inline std::string encode_png(const std::vector<uint8_t> &rgb, uint32_t width, uint32_t height) {
+    const size_t stride = static_cast<size_t>(width) * 3;
+
+    // Filtrar cada linha com o filtro de menor soma absoluta
+    std::vector<uint8_t> filtered;
+    filtered.reserve((stride + 1) * height);
+    std::vector<uint8_t> candidate[3];
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t *row = rgb.data() + y * stride;
+        const uint8_t *above = y > 0 ? row - stride : nullptr;
+        size_t best = 0, best_cost = SIZE_MAX;
+        for (size_t filter = 0; filter < 3; ++filter) {
+            candidate[filter].resize(stride);
+            size_t cost = 0;
+            for (size_t k = 0; k < stride; ++k) {
+                uint8_t predictor = filter == 1 ? (k >= 3 ? row[k - 3] : 0) : filter == 2 ? (above ? above[k] : 0) : 0;
+                uint8_t value = static_cast<uint8_t>(row[k] - predictor);
+                candidate[filter][k] = value;
+                cost += value < 128 ? value : 256 - value;
+            }
+            if (cost < best_cost) {
+                best = filter;
+                best_cost = cost;
+            }
+        }
+        filtered.push_back(static_cast<uint8_t>(best));
+        filtered.insert(filtered.end(), candidate[best].begin(), candidate[best].end());
+    }
+
+    std::string header;
+    for (uint32_t value : { width, height }) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            header += static_cast<char>((value >> shift) & 0xFF);
+        }
+    }
+    header += static_cast<char>(8); // bits por canal
+    header += static_cast<char>(2); // RGB
+    header += std::string(3, '\0'); // compressão, filtro e entrelaçamento padrão
+
+    std::string png("\x89PNG\r\n\x1a\n", 8);
+    put_png_chunk(png, "IHDR", header);
+    put_png_chunk(png, "IDAT", zlib_compress(filtered));
+    put_png_chunk(png, "IEND", "");
+    return png;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "entity.h"
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// Projeção dos quadros: quais campos de cada célula são enviados e com que precisão.
+//
+// Os codificadores são especializados em tempo de compilação para cada combinação de
+// campos (with_fields), de modo que o laço por célula não testa campos nem escreve as
+// colunas que não foram pedidas.
+
+// Defina os campos de uma célula que podem ser enviados
+enum entity_field : unsigned { type_field = 1, energy_field = 2, age_field = 4, all_fields = 7 };
+
+// Maior largura de faixa aceita na quantização de energia e idade
+static const uint32_t MAXIMUM_QUANTIZATION_BUCKET = 1000000;
+
+// Defina uma projeção: os campos enviados e a largura das faixas em que energia e idade
+// são arredondadas para baixo (1 = valores exatos)
+struct projection_t {
+    unsigned fields = all_fields;
+    uint32_t bucket = 1;
+
+    bool is_default() const {
+        return fields == all_fields && bucket == 1;
+    }
+
+    // Identificador da projeção, usado como chave de cache e na ETag ("" para a padrão)
+    std::string key() const {
+        if (is_default()) {
+            return "";
+        }
+        std::string key;
+        key += fields & type_field ? "t" : "";
+        key += fields & energy_field ? "e" : "";
+        key += fields & age_field ? "a" : "";
+        return bucket > 1 ? key + "q" + std::to_string(bucket) : key;
+    }
+};
+
+// Função para arredondar um valor para baixo até o início da sua faixa
+inline uint32_t quantize(uint32_t value, uint32_t bucket) {
+    return bucket > 1 ? value - value % bucket : value;
+}
+
+// Função para ler uma projeção dos parâmetros ?fields=type,energy,age e ?quantize=<largura>
+// (ambos opcionais)
+inline projection_t projectionFromQuery(const char *fields, const char *quantize_bucket) {
+    projection_t projection;
+    if (fields) {
+        projection.fields = 0;
+        std::stringstream list(fields);
+        std::string field;
+        while (std::getline(list, field, ',')) {
+            if (field == "type") {
+                projection.fields |= type_field;
+            } else if (field == "energy") {
+                projection.fields |= energy_field;
+            } else if (field == "age") {
+                projection.fields |= age_field;
+            } else {
+                throw std::invalid_argument("Campo desconhecido: " + field);
+            }
+        }
+        if (projection.fields == 0) {
+            throw std::invalid_argument("Nenhum campo selecionado");
+        }
+    }
+    if (quantize_bucket) {
+        char *end = nullptr;
+        unsigned long bucket = std::strtoul(quantize_bucket, &end, 10);
+        if (*end != '\0' || bucket == 0 || bucket > MAXIMUM_QUANTIZATION_BUCKET) {
+            throw std::invalid_argument("Largura de quantização inválida");
+        }
+        projection.bucket = static_cast<uint32_t>(bucket);
+    }
+    return projection;
+}
+
+// Função para chamar body com a combinação de campos como constante de compilação
+// (std::integral_constant<unsigned, campos>)
+template <typename Body>
+auto with_fields(unsigned fields, Body &&body) {
+    switch (fields) {
+        case 1: return body(std::integral_constant<unsigned, 1>());
+        case 2: return body(std::integral_constant<unsigned, 2>());
+        case 3: return body(std::integral_constant<unsigned, 3>());
+        case 4: return body(std::integral_constant<unsigned, 4>());
+        case 5: return body(std::integral_constant<unsigned, 5>());
+        case 6: return body(std::integral_constant<unsigned, 6>());
+        default: return body(std::integral_constant<unsigned, 7>());
+    }
+}
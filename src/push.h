@@ -0,0 +1,129 @@
+#pragma once
+
+#include "delta.h"
+#include "frame_cache.h"
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Envio de quadros aos clientes conectados por WebSocket.
+//
+// Cada publicação da grade é enviada a todos os clientes como um delta sobre o último
+// quadro que cada um recebeu. O cliente confirma cada quadro processado; quem tem
+// PUSH_MAXIMUM_IN_FLIGHT quadros sem confirmação não recebe mais nada até confirmar, e
+// nesse meio tempo as publicações se acumulam em um único delta, em vez de uma fila.
+
+// Número máximo de quadros enviados e ainda não confirmados por cliente
+static const unsigned PUSH_MAXIMUM_IN_FLIGHT = 2;
+
+class push_hub_t {
+public:
+    explicit push_hub_t(frame_cache_t &cache) : cache_(cache) {}
+
+    // Envia uma mensagem ao cliente (binária ou texto)
+    using send_t = std::function<void(const std::string &message, bool binary)>;
+
+    // Registrar um cliente; o primeiro quadro que ele receber será completo
+    void add(const void *id, send_t send) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_[id].send = std::move(send);
+    }
+
+    void remove(const void *id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_.erase(id);
+    }
+
+    // Escolher o formato dos quadros enviados ao cliente (binário por padrão); o próximo
+    // quadro será completo
+    void set_binary(const void *id, bool binary) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = clients_.find(id);
+        if (it != clients_.end()) {
+            it->second.binary = binary;
+            it->second.sent_version = 0;
+        }
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return clients_.size();
+    }
+
+    // Enviar a publicação atual a todos os clientes que podem recebê-la.
+    // Deve ser chamada com a grade travada, logo após change_log.record ou reset.
+    void publish(const grid_t &grid, const change_log_t &change_log, const frame_header_t &header) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &entry : clients_) {
+            // Clientes sem espaço ficam para trás e recebem tudo de uma vez ao confirmar
+            if (entry.second.in_flight < PUSH_MAXIMUM_IN_FLIGHT) {
+                send_latest(entry.second, grid, change_log, header);
+            }
+        }
+    }
+
+    // Registrar a confirmação de um quadro e enviar as publicações acumuladas, se houver.
+    // Deve ser chamada com a grade travada.
+    void ack(const void *id, const grid_t &grid, const change_log_t &change_log, const frame_header_t &header) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = clients_.find(id);
+        if (it != clients_.end() && it->second.in_flight > 0) {
+            it->second.in_flight--;
+        }
+        flush_client(id, grid, change_log, header);
+    }
+
+    // Enviar ao cliente, em um único delta, o que ele ainda não recebeu (se puder
+    // receber agora). Deve ser chamada com a grade travada.
+    void flush(const void *id, const grid_t &grid, const change_log_t &change_log, const frame_header_t &header) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flush_client(id, grid, change_log, header);
+    }
+
+private:
+    struct client_t {
+        send_t send;
+        bool binary = true;
+        unsigned in_flight = 0;
+        uint64_t sent_version = 0;
+    };
+
+    void flush_client(const void *id, const grid_t &grid, const change_log_t &change_log, const frame_header_t &header) {
+        auto it = clients_.find(id);
+        if (it == clients_.end()) {
+            return;
+        }
+        client_t &client = it->second;
+        if (client.in_flight < PUSH_MAXIMUM_IN_FLIGHT && client.sent_version != change_log.version()) {
+            send_latest(client, grid, change_log, header);
+        }
+    }
+
+    // Enviar ao cliente o que mudou desde o último quadro que ele recebeu. Clientes em
+    // dia pedem o mesmo delta, codificado uma única vez pelo cache de quadros.
+    void send_latest(client_t &client, const grid_t &grid, const change_log_t &change_log, const frame_header_t &header) {
+        std::vector<uint32_t> cells;
+        uint64_t since = client.sent_version;
+        if (!change_log.changes_since(since, cells) || !delta_pays_off(cells.size(), grid.size())) {
+            since = 0;
+        }
+
+        frame_header_t frame_header = header;
+        frame_header.since = since;
+        frame_key_t key;
+        key.version = header.version;
+        key.since = since;
+        key.format = client.binary ? binary_format : json_format;
+        std::shared_ptr<const std::string> message = cache_.get(key, [&]() { return encodeFrame(grid, frame_header, key.format, cells); });
+
+        client.send(*message, client.binary);
+        client.sent_version = change_log.version();
+        client.in_flight++;
+    }
+
+    frame_cache_t &cache_;
+    std::mutex mutex_;
+    std::unordered_map<const void *, client_t> clients_;
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "simulation.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <vector>
+
+// Pirâmide de resumos da grade em várias resoluções, para visões afastadas.
+//
+// No nível k, cada bloco resume um quadrado de 2^k x 2^k células: quantas há de cada
+// espécie e a soma da energia das entidades. O primeiro nível é calculado a partir das
+// células e cada nível seguinte a partir dos 4 blocos do anterior, de modo que montar
+// a pirâmide inteira custa pouco mais que uma passada pela grade, e consultar um
+// retângulo de blocos custa apenas o tamanho do retângulo.
+
+// Nível mais fino da pirâmide (blocos de 4 x 4 células); resoluções maiores são
+// atendidas diretamente pela grade
+static const uint32_t PYRAMID_BASE_LEVEL = 2;
+
+// Defina o resumo de um bloco de células
+struct block_summary_t {
+    uint32_t plants = 0;
+    uint32_t herbivores = 0;
+    uint32_t carnivores = 0;
+    uint64_t energy = 0;
+
+    uint32_t occupied() const {
+        return plants + herbivores + carnivores;
+    }
+
+    void add(const block_summary_t &other) {
+        plants += other.plants;
+        herbivores += other.herbivores;
+        carnivores += other.carnivores;
+        energy += other.energy;
+    }
+};
+
+// Defina um nível da pirâmide: blocos em ordem de linha
+struct pyramid_level_t {
+    uint32_t level = 0;
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    std::vector<block_summary_t> blocks;
+};
+
+// Defina a pirâmide: levels[0] é o nível PYRAMID_BASE_LEVEL e o último tem um único bloco
+struct pyramid_t {
+    std::vector<pyramid_level_t> levels;
+
+    uint32_t top_level() const {
+        return PYRAMID_BASE_LEVEL + static_cast<uint32_t>(levels.size()) - 1;
+    }
+
+    const pyramid_level_t &level(uint32_t level) const {
+        return levels[level - PYRAMID_BASE_LEVEL];
+    }
+};
+
+// Função para resumir o bloco (i, j) de um nível a partir dos 2 x 2 blocos do nível abaixo
+inline block_summary_t merge_blocks(const pyramid_level_t &lower, uint32_t i, uint32_t j) {
+    block_summary_t block;
+    for (uint32_t di = 0; di < 2 && 2 * i + di < lower.rows; ++di) {
+        for (uint32_t dj = 0; dj < 2 && 2 * j + dj < lower.cols; ++dj) {
+            block.add(lower.blocks[static_cast<size_t>(2 * i + di) * lower.cols + 2 * j + dj]);
+        }
+    }
+    return block;
+}
+
+// Função para calcular a memória ocupada pela pirâmide, em bytes
+inline size_t pyramid_memory_bytes(const pyramid_t &pyramid) {
+    size_t bytes = 0;
+    for (const pyramid_level_t &level : pyramid.levels) {
+        bytes += level.blocks.size() * sizeof(block_summary_t);
+    }
+    return bytes;
+}
+
+// Função para montar a pirâmide de resumos de uma grade
+inline pyramid_t build_pyramid(const grid_t &grid) {
+    pyramid_t pyramid;
+
+    // Nível base, a partir das células (uma linha de blocos por tarefa)
+    const uint32_t side = 1u << PYRAMID_BASE_LEVEL;
+    pyramid_level_t base;
+    base.level = PYRAMID_BASE_LEVEL;
+    base.rows = (grid.rows + side - 1) / side;
+    base.cols = (grid.cols + side - 1) / side;
+    base.blocks.resize(static_cast<size_t>(base.rows) * base.cols);
+    parallel_for(base.rows, [&](size_t block_row) {
+        block_summary_t *blocks = base.blocks.data() + block_row * base.cols;
+        const uint32_t i1 = std::min<uint32_t>(grid.rows, (block_row + 1) * side);
+        for (uint32_t i = block_row * side; i < i1; ++i) {
+            const entity_t *row = grid[i];
+            for (uint32_t j = 0; j < grid.cols; ++j) {
+                block_summary_t &block = blocks[j / side];
+                block.plants += row[j].type == plant;
+                block.herbivores += row[j].type == herbivore;
+                block.carnivores += row[j].type == carnivore;
+                block.energy += row[j].type != empty ? row[j].energy : 0;
+            }
+        }
+    });
+    pyramid.levels.push_back(std::move(base));
+
+    // Níveis seguintes, juntando 2 x 2 blocos do anterior, até restar um único bloco
+    while (pyramid.levels.back().rows > 1 || pyramid.levels.back().cols > 1) {
+        const pyramid_level_t &lower = pyramid.levels.back();
+        pyramid_level_t upper;
+        upper.level = lower.level + 1;
+        upper.rows = (lower.rows + 1) / 2;
+        upper.cols = (lower.cols + 1) / 2;
+        upper.blocks.resize(static_cast<size_t>(upper.rows) * upper.cols);
+        parallel_for(upper.rows, [&](size_t i) {
+            for (uint32_t j = 0; j < upper.cols; ++j) {
+                upper.blocks[i * upper.cols + j] = merge_blocks(lower, i, j);
+            }
+        });
+        pyramid.levels.push_back(std::move(upper));
+    }
+    return pyramid;
+}
+
+// Função para atualizar a pirâmide de uma grade depois que as células cells (índices na
+// grade) mudaram: refaz os blocos do nível base que as contêm e, em cada nível acima, os
+// blocos que contêm os refeitos. O custo é proporcional às células alteradas vezes o
+// número de níveis, e não ao tamanho da grade.
+inline void update_pyramid(pyramid_t &pyramid, const grid_t &grid, const std::vector<uint32_t> &cells) {
+    const uint32_t side = 1u << PYRAMID_BASE_LEVEL;
+    pyramid_level_t &base = pyramid.levels.front();
+    std::vector<size_t> dirty;
+    dirty.reserve(cells.size());
+    for (uint32_t cell : cells) {
+        dirty.push_back(static_cast<size_t>(cell / grid.cols / side) * base.cols + cell % grid.cols / side);
+    }
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+    for (size_t index : dirty) {
+        const uint32_t block_row = static_cast<uint32_t>(index / base.cols);
+        const uint32_t block_col = static_cast<uint32_t>(index % base.cols);
+        block_summary_t block;
+        for (uint32_t i = block_row * side; i < std::min(grid.rows, (block_row + 1) * side); ++i) {
+            for (uint32_t j = block_col * side; j < std::min(grid.cols, (block_col + 1) * side); ++j) {
+                const entity_t &entity = grid[i][j];
+                block.plants += entity.type == plant;
+                block.herbivores += entity.type == herbivore;
+                block.carnivores += entity.type == carnivore;
+                block.energy += entity.type != empty ? entity.energy : 0;
+            }
+        }
+        base.blocks[index] = block;
+    }
+
+    for (size_t k = 1; k < pyramid.levels.size(); ++k) {
+        const pyramid_level_t &lower = pyramid.levels[k - 1];
+        pyramid_level_t &upper = pyramid.levels[k];
+        for (size_t &index : dirty) {
+            index = static_cast<size_t>(index / lower.cols / 2) * upper.cols + index % lower.cols / 2;
+        }
+        std::sort(dirty.begin(), dirty.end());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+        for (size_t index : dirty) {
+            upper.blocks[index] = merge_blocks(lower, static_cast<uint32_t>(index / upper.cols), static_cast<uint32_t>(index % upper.cols));
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "json.hpp"
+#include "entity.h"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+// Defina o conjunto de regras da simulação (inicializado com as constantes padrão)
+struct rules_t {
+    double plant_reproduction_probability = PLANT_REPRODUCTION_PROBABILITY;
+    double herbivore_move_probability = HERBIVORE_MOVE_PROBABILITY;
+    double herbivore_eat_probability = HERBIVORE_EAT_PROBABILITY;
+    double herbivore_reproduction_probability = HERBIVORE_REPRODUCTION_PROBABILITY;
+    double carnivore_move_probability = CARNIVORE_MOVE_PROBABILITY;
+    double carnivore_eat_probability = CARNIVORE_EAT_PROBABILITY;
+    double carnivore_reproduction_probability = CARNIVORE_REPRODUCTION_PROBABILITY;
+    uint32_t maximum_energy = MAXIMUM_ENERGY;
+    uint32_t threshold_energy_for_reproduction = THRESHOLD_ENERGY_FOR_REPRODUCTION;
+    uint32_t herbivore_initial_energy = HERBIVORE_INITIAL_ENERGY;
+    uint32_t herbivore_initial_age = HERBIVORE_INITIAL_AGE;
+    uint32_t carnivore_initial_energy = CARNIVORE_INITIAL_ENERGY;
+    uint32_t carnivore_initial_age = CARNIVORE_INITIAL_AGE;
+};
+
+// Maior valor aceito para energias e idades configuráveis
+static const uint32_t MAXIMUM_RULE_VALUE = 1000000;
+
+// Custo de energia da reprodução de um carnívoro, o maior entre as espécies
+static const uint32_t REPRODUCTION_ENERGY_COST = 20;
+
+// Descrição de um campo de regras, usada para ler, escrever e varrer parâmetros pelo nome
+struct rule_field_t {
+    const char *name;
+    double rules_t::*real;
+    uint32_t rules_t::*integer;
+};
+
+static const rule_field_t RULE_FIELDS[] = {
+    { "plant_reproduction_probability", &rules_t::plant_reproduction_probability, nullptr },
+    { "herbivore_move_probability", &rules_t::herbivore_move_probability, nullptr },
+    { "herbivore_eat_probability", &rules_t::herbivore_eat_probability, nullptr },
+    { "herbivore_reproduction_probability", &rules_t::herbivore_reproduction_probability, nullptr },
+    { "carnivore_move_probability", &rules_t::carnivore_move_probability, nullptr },
+    { "carnivore_eat_probability", &rules_t::carnivore_eat_probability, nullptr },
+    { "carnivore_reproduction_probability", &rules_t::carnivore_reproduction_probability, nullptr },
+    { "maximum_energy", nullptr, &rules_t::maximum_energy },
+    { "threshold_energy_for_reproduction", nullptr, &rules_t::threshold_energy_for_reproduction },
+    { "herbivore_initial_energy", nullptr, &rules_t::herbivore_initial_energy },
+    { "herbivore_initial_age", nullptr, &rules_t::herbivore_initial_age },
+    { "carnivore_initial_energy", nullptr, &rules_t::carnivore_initial_energy },
+    { "carnivore_initial_age", nullptr, &rules_t::carnivore_initial_age },
+};
+
+// Função para encontrar a descrição de um campo de regras pelo nome
+inline const rule_field_t *find_rule_field(const std::string &name) {
+    for (const rule_field_t &field : RULE_FIELDS) {
+        if (name == field.name) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+// Função para atribuir um valor numérico a um campo de regras.
+// Campos inteiros são verificados antes da conversão, que seria indefinida fora do intervalo
+inline void set_rule_field(rules_t &rules, const rule_field_t &field, double value) {
+    if (field.real) {
+        rules.*field.real = value;
+    } else {
+        if (!(std::isfinite(value) && value >= 0.0 && value <= MAXIMUM_RULE_VALUE)) {
+            throw std::invalid_argument(std::string("Valor inválido para a regra ") + field.name);
+        }
+        rules.*field.integer = static_cast<uint32_t>(value + 0.5);
+    }
+}
+
+// Função para ler o valor numérico de um campo de regras
+inline double get_rule_field(const rules_t &rules, const rule_field_t &field) {
+    return field.real ? rules.*field.real : static_cast<double>(rules.*field.integer);
+}
+
+// Função para validar um conjunto de regras completo
+inline void validate_rules(const rules_t &rules) {
+    for (const rule_field_t &field : RULE_FIELDS) {
+        if (field.real) {
+            double value = rules.*field.real;
+            if (!(value >= 0.0 && value <= 1.0)) {
+                throw std::invalid_argument(std::string("A probabilidade ") + field.name + " deve estar entre 0 e 1");
+            }
+        } else if (rules.*field.integer > MAXIMUM_RULE_VALUE) {
+            throw std::invalid_argument(std::string("Valor muito grande para a regra ") + field.name);
+        }
+    }
+    if (rules.maximum_energy == 0 || rules.herbivore_initial_energy == 0 || rules.carnivore_initial_energy == 0) {
+        throw std::invalid_argument("As energias iniciais devem ser positivas");
+    }
+    // A reprodução desconta energia sem verificar o saldo; o limiar impede o estouro negativo
+    if (rules.threshold_energy_for_reproduction < REPRODUCTION_ENERGY_COST) {
+        throw std::invalid_argument("threshold_energy_for_reproduction deve ser pelo menos " + std::to_string(REPRODUCTION_ENERGY_COST));
+    }
+}
+
+// Função para converter as regras em um objeto JSON
+inline nlohmann::json rulesToJson(const rules_t &rules) {
+    nlohmann::json json_rules = nlohmann::json::object();
+    for (const rule_field_t &field : RULE_FIELDS) {
+        if (field.real) {
+            json_rules[field.name] = rules.*field.real;
+        } else {
+            json_rules[field.name] = rules.*field.integer;
+        }
+    }
+    return json_rules;
+}
+
+// Função para aplicar as regras presentes em um objeto JSON sobre um conjunto existente e validar o resultado
+inline rules_t rulesFromJson(const nlohmann::json &json_rules, rules_t rules = rules_t()) {
+    if (!json_rules.is_object()) {
+        throw std::invalid_argument("As regras devem ser um objeto JSON");
+    }
+    for (auto it = json_rules.begin(); it != json_rules.end(); ++it) {
+        const rule_field_t *field = find_rule_field(it.key());
+        if (!field) {
+            throw std::invalid_argument("Regra desconhecida: " + it.key());
+        }
+        if (!it.value().is_number()) {
+            throw std::invalid_argument("Valor inválido para a regra " + it.key());
+        }
+        set_rule_field(rules, *field, it.value().get<double>());
+    }
+    validate_rules(rules);
+    return rules;
+}
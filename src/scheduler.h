@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+// Escalonamento do tempo de CPU do motor entre as sessões.
+//
+// Todo trabalho de simulação (quadros interativos, jobs, cálculos antecipados, avanços
+// rápidos) roda com uma concessão de um dos slots do escalonador, um por núcleo por padrão.
+// Quando há mais trabalho que slots, o próximo a rodar é o da classe de prioridade mais alta
+// (interativa antes de lote) e, dentro da classe, o da sessão com menor tempo virtual: o
+// tempo de CPU já usado dividido pelo peso da sessão. O trabalho longo devolve o slot a
+// cada SCHEDULER_QUANTUM (entre iterações, ou entre fatias de linhas de uma iteração), de
+// modo que um job pesado não atrasa os quadros interativos das outras sessões por mais que
+// um quantum.
+
+// Fatia de tempo de uma concessão antes de dar a vez a quem espera
+static const std::chrono::milliseconds SCHEDULER_QUANTUM(10);
+
+// Limites aceitos para o peso de uma sessão
+static const double SCHEDULER_MINIMUM_WEIGHT = 0.01;
+static const double SCHEDULER_MAXIMUM_WEIGHT = 100;
+
+// Defina as classes de prioridade (menor valor roda antes)
+enum cpu_priority_t { interactive_priority = 0, batch_priority = 1 };
+
+// Função para obter o tempo de CPU consumido pela thread atual, em nanossegundos
+inline uint64_t thread_cpu_ns() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return uint64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// Função para obter o tempo de parede monotônico, em nanossegundos
+inline uint64_t steady_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Defina os relógios do escalonador: o tempo de CPU da thread atual (cobrado das contas) e o
+// tempo de parede (quantum e espera). Os testes trocam por relógios controlados.
+struct scheduler_clock_t {
+    uint64_t (*cpu_ns)() = thread_cpu_ns;
+    uint64_t (*wall_ns)() = steady_clock_ns;
+};
+
+// Defina a conta de CPU de uma sessão: peso, tempo virtual e métricas
+struct cpu_account_t {
+    std::atomic<double> weight{ 1 };
+    double virtual_time = 0; // protegido pelo mutex do escalonador
+
+    // Tempo de CPU usado por classe e tempo de espera por um slot, em nanossegundos
+    std::atomic<uint64_t> interactive_ns{ 0 };
+    std::atomic<uint64_t> batch_ns{ 0 };
+    std::atomic<uint64_t> waited_ns{ 0 };
+};
+
+class cpu_scheduler_t;
+
+// Defina uma concessão de um slot do escalonador; o slot é devolvido na destruição
+class cpu_grant_t {
+public:
+    cpu_grant_t() = default;
+    cpu_grant_t(const cpu_grant_t &) = delete;
+    cpu_grant_t &operator=(const cpu_grant_t &) = delete;
+    cpu_grant_t(cpu_grant_t &&other) noexcept { *this = std::move(other); }
+    cpu_grant_t &operator=(cpu_grant_t &&other) noexcept;
+    ~cpu_grant_t();
+
+    explicit operator bool() const {
+        return scheduler_ != nullptr;
+    }
+
+    // Dar a vez a quem espera se o quantum já foi usado (e esperar a próxima vez)
+    void yield();
+
+private:
+    friend class cpu_scheduler_t;
+
+    cpu_scheduler_t *scheduler_ = nullptr;
+    cpu_account_t *account_ = nullptr;
+    cpu_priority_t priority_ = batch_priority;
+    uint64_t started_ns_ = 0;
+    uint64_t started_cpu_ns_ = 0;
+};
+
+// Defina o escalonador: slots de CPU concedidos por prioridade e tempo virtual
+class cpu_scheduler_t {
+public:
+    explicit cpu_scheduler_t(unsigned slots = std::thread::hardware_concurrency(), scheduler_clock_t clock = scheduler_clock_t()) : clock_(clock), slots_(std::max(1u, slots)), free_(int(slots_)) {}
+
+    // Definir o número de slots (por exemplo, na configuração do servidor)
+    void set_slots(unsigned slots) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_ += int(std::max(1u, slots)) - int(slots_);
+        slots_ = std::max(1u, slots);
+        grant_waiters();
+    }
+
+    // Número de pedidos esperando um slot
+    size_t waiting() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return waiting_.size();
+    }
+
+    // Esperar a vez da conta na classe de prioridade e obter um slot
+    cpu_grant_t acquire(cpu_account_t &account, cpu_priority_t priority) {
+        const uint64_t started = clock_.wall_ns();
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_turn(lock, account, priority);
+        account.waited_ns += clock_.wall_ns() - started;
+        return make_grant(account, priority);
+    }
+
+    // Obter um slot apenas se houver um livre e ninguém esperando (trabalho oportunista);
+    // caso contrário, retorna uma concessão vazia
+    cpu_grant_t try_acquire(cpu_account_t &account, cpu_priority_t priority) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_ <= 0 || !waiting_.empty()) {
+            return cpu_grant_t();
+        }
+        --free_;
+        catch_up(account);
+        virtual_clock_ = std::max(virtual_clock_, account.virtual_time); // o relógio virtual nunca volta
+        return make_grant(account, priority);
+    }
+
+private:
+    friend class cpu_grant_t;
+
+    struct waiter_t {
+        cpu_account_t *account;
+        cpu_priority_t priority;
+        uint64_t sequence;
+        bool granted = false;
+    };
+
+    // Se a vez de a vem antes da de b
+    static bool before(const waiter_t &a, const waiter_t &b) {
+        if (a.priority != b.priority) {
+            return a.priority < b.priority;
+        }
+        if (a.account->virtual_time != b.account->virtual_time) {
+            return a.account->virtual_time < b.account->virtual_time;
+        }
+        return a.sequence < b.sequence;
+    }
+
+    // Uma conta que volta depois de ociosa não acumula crédito: seu tempo virtual começa
+    // no da última conta que recebeu um slot
+    void catch_up(cpu_account_t &account) {
+        account.virtual_time = std::max(account.virtual_time, virtual_clock_);
+    }
+
+    void wait_turn(std::unique_lock<std::mutex> &lock, cpu_account_t &account, cpu_priority_t priority) {
+        waiter_t waiter{ &account, priority, sequence_++ };
+        catch_up(account);
+        waiting_.push_back(&waiter);
+        grant_waiters();
+        turn_.wait(lock, [&]() { return waiter.granted; });
+    }
+
+    // Conceder os slots livres aos primeiros da fila
+    void grant_waiters() {
+        while (free_ > 0 && !waiting_.empty()) {
+            auto best = std::min_element(waiting_.begin(), waiting_.end(), [](const waiter_t *a, const waiter_t *b) { return before(*a, *b); });
+            waiter_t *waiter = *best;
+            waiting_.erase(best);
+            --free_;
+            virtual_clock_ = std::max(virtual_clock_, waiter->account->virtual_time);
+            waiter->granted = true;
+            turn_.notify_all();
+        }
+    }
+
+    cpu_grant_t make_grant(cpu_account_t &account, cpu_priority_t priority) {
+        cpu_grant_t grant;
+        grant.scheduler_ = this;
+        grant.account_ = &account;
+        grant.priority_ = priority;
+        grant.started_ns_ = clock_.wall_ns();
+        grant.started_cpu_ns_ = clock_.cpu_ns();
+        return grant;
+    }
+
+    // Registrar o tempo de CPU usado desde o início da concessão (ou da última cobrança)
+    void charge(cpu_grant_t &grant) {
+        const uint64_t now = clock_.cpu_ns();
+        const uint64_t used = now - grant.started_cpu_ns_;
+        grant.started_cpu_ns_ = now;
+        grant.started_ns_ = clock_.wall_ns();
+        (grant.priority_ == interactive_priority ? grant.account_->interactive_ns : grant.account_->batch_ns) += used;
+        grant.account_->virtual_time += used / 1e9 / grant.account_->weight;
+    }
+
+    void release(cpu_grant_t &grant) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        charge(grant);
+        ++free_;
+        grant_waiters();
+    }
+
+    void yield(cpu_grant_t &grant) {
+        if (clock_.wall_ns() - grant.started_ns_ < uint64_t(std::chrono::nanoseconds(SCHEDULER_QUANTUM).count())) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        charge(grant);
+        const waiter_t self{ grant.account_, grant.priority_, sequence_ };
+        const bool someone_first = std::any_of(waiting_.begin(), waiting_.end(), [&](const waiter_t *waiter) { return before(*waiter, self); });
+        if (!someone_first) {
+            return;
+        }
+
+        const uint64_t started = clock_.wall_ns();
+        ++free_;
+        wait_turn(lock, *grant.account_, grant.priority_);
+        grant.account_->waited_ns += clock_.wall_ns() - started;
+        grant.started_ns_ = clock_.wall_ns();
+        grant.started_cpu_ns_ = clock_.cpu_ns();
+    }
+
+    const scheduler_clock_t clock_;
+    std::mutex mutex_;
+    std::condition_variable turn_;
+    std::vector<waiter_t *> waiting_;
+    unsigned slots_;
+    int free_;
+    uint64_t sequence_ = 0;
+    double virtual_clock_ = 0;
+};
+
+inline cpu_grant_t &cpu_grant_t::operator=(cpu_grant_t &&other) noexcept {
+    if (this != &other) {
+        if (scheduler_) {
+            scheduler_->release(*this);
+        }
+        scheduler_ = other.scheduler_;
+        account_ = other.account_;
+        priority_ = other.priority_;
+        started_ns_ = other.started_ns_;
+        started_cpu_ns_ = other.started_cpu_ns_;
+        other.scheduler_ = nullptr;
+    }
+    return *this;
+}
+
+inline cpu_grant_t::~cpu_grant_t() {
+    if (scheduler_) {
+        scheduler_->release(*this);
+    }
+}
+
+inline void cpu_grant_t::yield() {
+    if (scheduler_) {
+        scheduler_->yield(*this);
+    }
+}
+
+// Função para obter o escalonador do motor, compartilhado por todas as sessões
+inline cpu_scheduler_t &engine_scheduler() {
+    static cpu_scheduler_t scheduler;
+    return scheduler;
+}
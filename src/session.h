@@ -0,0 +1,734 @@
+#pragma once
+
+#include "delta.h"
+#include "frame_cache.h"
+#include "pacing.h"
+#include "push.h"
+#include "rules.h"
+#include "scheduler.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "strand.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Sessões de simulação independentes.
+//
+// Cada sessão tem seu próprio mundo, gerador de números aleatórios, regras, registro de
+// alterações, cache de quadros, clientes WebSocket, mutex e strand; pedidos para sessões
+// diferentes só compartilham a busca no registro. As versões das publicações vêm de um
+// contador global, de modo que uma versão (e a ETag de um quadro) identifica a
+// publicação mesmo entre sessões diferentes.
+//
+// O registro contabiliza a memória de cada sessão (grade, registro de alterações,
+// publicação e cache de quadros). Uma thread do registro confere o total periodicamente,
+// fora do caminho dos pedidos; quando ele passa do orçamento, as sessões usadas há mais
+// tempo têm o mundo gravado em disco como um quadro binário completo e a memória liberada,
+// até o total cair a uma fração do orçamento. O próximo pedido para a sessão recarrega o
+// mundo sem que o cliente perceba.
+
+// Orçamento de memória padrão de todas as sessões
+static const size_t SESSION_DEFAULT_MEMORY_BUDGET = size_t(4) << 30;
+
+// Intervalo entre as verificações do orçamento de memória
+static const std::chrono::milliseconds SESSION_EVICTION_INTERVAL{ 250 };
+
+// Fração do orçamento (em porcentagem) à qual o despejo reduz o total, para que sessões
+// recarregadas não voltem a passar do orçamento logo em seguida
+static const size_t SESSION_EVICTION_TARGET_PERCENT = 75;
+
+// Tempo mínimo sem acessos para que uma sessão possa ser despejada: mundos em uso
+// ativo ficam em memória, mesmo que o total passe do orçamento por algum tempo
+static const int64_t SESSION_EVICTION_MINIMUM_IDLE_MS = 1000;
+
+// Número máximo padrão de sessões abertas (o orçamento só move mundos para o disco, então
+// sem um limite o disco e o registro cresceriam sem fim)
+static const size_t SESSION_DEFAULT_MAXIMUM_COUNT = 256;
+
+// Número máximo padrão de pedidos de clientes esperando a vez no strand de uma sessão. Cada
+// um prende uma thread do servidor; acima do limite o pedido é recusado com 503, de modo
+// que um mundo muito disputado não ocupa todas as threads e atrasa os outros mundos.
+static const size_t SESSION_DEFAULT_MAXIMUM_WAITING = 2;
+
+// Número máximo de lotes de iterações calculados de antemão por sessão, e memória máxima
+// que eles podem ocupar
+static const size_t SPECULATION_DEPTH = 4;
+static const size_t SPECULATION_MAXIMUM_BYTES = size_t(64) << 20;
+
+// Defina um lote de iterações calculado de antemão: o mundo ao fim do lote e as regras
+// com que ele foi calculado
+struct speculative_frame_t {
+    grid_t grid;
+    std::mt19937 gen;
+    population_t population;
+    std::shared_ptr<const rules_t> rules;
+    unsigned iterations = 0;
+    changed_cells_t changed; // células escritas desde o lote anterior
+};
+
+// Função para obter o instante atual em milissegundos (usado para ordenar o despejo)
+inline int64_t session_clock_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Função para obter a versão da próxima publicação de qualquer sessão
+inline uint64_t next_publication_version() {
+    static std::atomic<uint64_t> version{ 0 };
+    return ++version;
+}
+
+// Defina uma sessão de simulação
+struct session_t {
+    explicit session_t(uint64_t id) : id(id), gen(std::random_device{}()), push_hub(frame_cache) {}
+
+    ~session_t() {
+        if (!spill_path.empty()) {
+            std::remove(spill_path.c_str());
+        }
+    }
+
+    const uint64_t id;
+
+    // Gerador de números aleatórios da simulação
+    std::mt19937 gen;
+
+    // Semente usada para gerar o estado inicial do mundo atual (devolvida no cabeçalho X-Seed)
+    uint64_t seed = 0;
+
+    // Número de iterações simuladas desde o início do mundo atual
+    uint64_t tick = 0;
+
+    // Grade de entidades
+    grid_t grid{ NUM_ROWS, NUM_ROWS };
+
+    // População de cada espécie na grade, mantida a cada iteração sem percorrer a grade
+    population_t population;
+
+    // Registro das células alteradas a cada publicação da grade
+    change_log_t change_log;
+
+    // Regras da simulação. Cada atualização publica um novo objeto imutável de forma
+    // atômica; a simulação lê o ponteiro uma vez por iteração, e os leitores não
+    // precisam do mutex.
+    std::shared_ptr<const rules_t> rules = std::make_shared<const rules_t>();
+
+    // Cache de quadros codificados, compartilhado pelos clientes da sessão
+    frame_cache_t frame_cache;
+
+    // Clientes conectados por WebSocket que recebem cada publicação da grade
+    push_hub_t push_hub;
+
+    // Última publicação da grade, lida pelos endpoints que não precisam do mutex
+    std::shared_ptr<const world_snapshot_t> snapshot;
+
+    // Mutex da grade, do gerador e do registro de alterações
+    std::mutex mutex;
+
+    // Executor serial dos pedidos que alteram ou leem o mundo (início, iterações, quadros),
+    // e quantos pedidos de clientes podem esperar a vez nele (ver run_request)
+    strand_t strand;
+    size_t maximum_waiting = SESSION_DEFAULT_MAXIMUM_WAITING;
+
+    // Controlador do número de iterações por quadro entregue
+    frame_pacer_t pacer;
+
+    // Conta de CPU da sessão no escalonador do motor (peso e tempo usado)
+    cpu_account_t account;
+
+    // Lotes de iterações calculados de antemão a partir da publicação speculation_base,
+    // em ordem. Só o strand os altera.
+    std::deque<speculative_frame_t> speculation;
+    uint64_t speculation_base = 0;
+
+    // Memória ocupada pelos lotes calculados de antemão, e se há uma tarefa calculando-os
+    std::atomic<size_t> speculation_bytes{ 0 };
+    std::atomic<bool> speculating{ false };
+
+    // Iteração em andamento simulada em fatias (ver advance_slice), a publicação da qual ela
+    // parte e a memória que ela ocupa. Só o strand a altera.
+    std::unique_ptr<sliced_iteration_t> pending;
+    uint64_t pending_base = 0;
+    std::atomic<size_t> pending_bytes{ 0 };
+
+    // Instante do último acesso, em milissegundos (as sessões usadas há mais tempo são
+    // despejadas primeiro)
+    std::atomic<int64_t> last_access{ session_clock_ms() };
+
+    // Memória ocupada pela grade e pelo registro de alterações, atualizada a cada publicação
+    std::atomic<size_t> resident_bytes{ 0 };
+
+    // Arquivo com o mundo despejado ("" se a sessão está em memória), com o cabeçalho e as
+    // dimensões da grade gravada. Protegidos pelo mutex.
+    std::string spill_path;
+    frame_header_t spilled_header;
+    uint32_t spilled_rows = 0;
+    uint32_t spilled_cols = 0;
+
+    // Descrição da falha ao recarregar o mundo despejado ("" se não houve desde o último
+    // recomeço), mostrada no resumo da sessão. Protegida pelo mutex.
+    std::string reload_error;
+
+    void touch() {
+        last_access = session_clock_ms();
+    }
+
+    // Memória ocupada pela sessão, em bytes
+    size_t memory_bytes() {
+        std::shared_ptr<const world_snapshot_t> current = std::atomic_load(&snapshot);
+        return resident_bytes + speculation_bytes + pending_bytes + frame_cache.memory_bytes() + (current ? current->memory_bytes() : 0);
+    }
+
+    // Executar uma tarefa no strand da sessão, com o mundo em memória (recarregado do
+    // disco se tiver sido despejado)
+    template <typename Task>
+    auto run(Task &&task) -> decltype(task()) {
+        touch();
+        return strand.run([&]() {
+            reload();
+            return task();
+        });
+    }
+
+    // Executar o pedido de um cliente como run, se no máximo maximum_waiting pedidos já
+    // esperam a vez; retorna false, sem executá-lo, se a sessão está ocupada demais
+    template <typename Task>
+    bool run_request(Task &&task) {
+        touch();
+        return strand.run_bounded(maximum_waiting, [&]() {
+            reload();
+            task();
+        });
+    }
+
+    // Última publicação da grade, recarregando o mundo se ele tiver sido despejado
+    std::shared_ptr<const world_snapshot_t> view() {
+        touch();
+        std::shared_ptr<const world_snapshot_t> current = std::atomic_load(&snapshot);
+        return current ? current : run([&]() { return std::atomic_load(&snapshot); });
+    }
+
+    // Cabeçalho de quadro da publicação atual
+    frame_header_t current_header() const {
+        frame_header_t header;
+        header.tick = tick;
+        header.seed = seed;
+        header.version = change_log.version();
+        return header;
+    }
+
+    // Publicar o estado atual da grade para os leitores e para os clientes conectados.
+    // Deve ser chamada com o mutex bloqueado, depois de atualizar o change_log.
+    void publish() {
+        auto published = std::make_shared<world_snapshot_t>(grid, current_header());
+        published->follow_pyramid(std::atomic_load(&snapshot).get(), change_log);
+        publish(std::move(published));
+    }
+
+    // Publicar uma publicação já montada a partir da grade atual
+    void publish(std::shared_ptr<const world_snapshot_t> published) {
+        const frame_header_t header = published->header;
+        std::atomic_store(&snapshot, std::move(published));
+        push_hub.publish(grid, change_log, header);
+        resident_bytes = grid.size() * sizeof(entity_t) + change_log.memory_bytes();
+    }
+
+    // Recomeçar o registro e publicar um mundo novo, depois de preencher a grade (que partiu
+    // vazia) com placed_population entidades. Se placed lista as células preenchidas, a
+    // publicação copia só elas e o recomeço custa o número de entidades, e não o de células;
+    // com nullptr, a grade inteira é copiada. A pirâmide da publicação anterior não é
+    // herdada: a do mundo novo é montada no primeiro pedido. Deve ser chamada com o mutex
+    // bloqueado.
+    void restart(const population_t &placed_population, const changed_cells_t *placed) {
+        reload_error.clear();
+        clear_speculation();
+        clear_pending();
+        population = placed_population;
+        change_log.reset(grid, next_publication_version());
+        const frame_header_t header = current_header();
+        publish(placed && !placed->overflow ? std::make_shared<world_snapshot_t>(grid, header, placed->cells) : std::make_shared<world_snapshot_t>(grid, header));
+    }
+
+    // Avançar a simulação em um quadro de iterations iterações (0 deixa o pacer escolher) e
+    // publicar o resultado. Se o lote já foi calculado de antemão, apenas o publica. Deve ser
+    // chamada no strand. Retorna o número de iterações do quadro; *speculated indica se o
+    // lote veio dos cálculos antecipados.
+    unsigned advance(unsigned iterations = 0, bool *speculated = nullptr) {
+        cpu_grant_t grant = engine_scheduler().acquire(account, interactive_priority);
+        const unsigned taken = take_speculation(iterations);
+        if (speculated) {
+            *speculated = taken > 0;
+        }
+        if (taken > 0) {
+            return taken;
+        }
+        const unsigned chosen = iterations > 0 ? iterations : pacer.iterations();
+        advance_while(chosen, [](const population_t &) { return true; });
+        return chosen;
+    }
+
+    // Calcular de antemão mais um lote de iterations iterações (0 deixa o pacer escolher)
+    // depois do último já calculado, sem alterar o mundo. Deve ser chamada no strand.
+    // Retorna false se não há mais espaço para lotes, se a sessão foi despejada ou se suas
+    // iterações são simuladas em fatias (um lote seguraria o strand por tempo demais).
+    bool speculate(unsigned iterations) {
+        discard_stale_speculation();
+        const size_t frame_bytes = grid.size() * sizeof(entity_t);
+        if (!spill_path.empty() || pending || pacer.slice_iterations() || speculation.size() >= SPECULATION_DEPTH || (speculation.size() + 1) * frame_bytes > SPECULATION_MAXIMUM_BYTES) {
+            return false;
+        }
+        // Só calcular de antemão com um slot de CPU livre, sem atrasar o trabalho de ninguém
+        cpu_grant_t grant = engine_scheduler().try_acquire(account, batch_priority);
+        if (!grant) {
+            return false;
+        }
+
+        if (speculation.empty()) {
+            speculation_base = change_log.version();
+        }
+        const speculative_frame_t *last = speculation.empty() ? nullptr : &speculation.back();
+        speculative_frame_t frame{ last ? last->grid : grid, last ? last->gen : gen, last ? last->population : population, std::atomic_load(&rules), iterations > 0 ? iterations : pacer.iterations() };
+        const auto started = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < frame.iterations; ++i) {
+            simulate_iteration(frame.grid, frame.gen, *frame.rules, &frame.population, &frame.changed);
+        }
+        pacer.measure(frame.iterations, std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+        speculation.push_back(std::move(frame));
+        speculation_bytes = speculation.size() * frame_bytes;
+        return true;
+    }
+
+    // Descartar os lotes calculados de antemão. Deve ser chamada no strand.
+    void clear_speculation() {
+        speculation.clear();
+        speculation_bytes = 0;
+    }
+
+    // Avançar por até budget a iteração em andamento (ou começar uma nova, a partir da
+    // publicação atual) e publicá-la quando terminar; até lá os leitores continuam vendo a
+    // última publicação, e o mutex só é bloqueado na publicação. Deve ser chamada no strand.
+    // Retorna true quando a iteração foi publicada.
+    bool advance_slice(std::chrono::steady_clock::duration budget, cpu_priority_t priority = interactive_priority) {
+        cpu_grant_t grant = engine_scheduler().acquire(account, priority);
+        const auto deadline = std::chrono::steady_clock::now() + budget;
+        if (pending && pending_base != change_log.version()) {
+            clear_pending(); // o mundo mudou por outro caminho: recomeçar a iteração
+        }
+        if (!pending) {
+            pending = std::make_unique<sliced_iteration_t>(grid, gen, population, std::atomic_load(&rules));
+            pending_base = change_log.version();
+            pending_bytes = 2 * grid.size() * sizeof(entity_t);
+        }
+        if (!pending->resume(deadline)) {
+            return false;
+        }
+
+        pacer.measure(1, pending->seconds);
+        std::lock_guard<std::mutex> lock(mutex);
+        grid = std::move(pending->next);
+        gen = pending->gen;
+        population = pending->population;
+        ++tick;
+        change_log.record(grid, next_publication_version(), pending->changed);
+        clear_pending();
+        publish();
+        return true;
+    }
+
+    // Avançar uma iteração em fatias de até budget, cada uma em uma vez do strand: os
+    // pedidos que chegam no meio são atendidos entre as fatias. Para antes se o mundo for
+    // avançado por outro caminho nesse meio tempo. Não deve ser chamada no strand. A
+    // primeira fatia entra como um pedido de cliente (run_request); retorna 0 se a sessão
+    // estava ocupada demais para aceitá-lo, ou o número de fatias; *completed indica se a
+    // iteração terminou (false se foi interrompida pelo outro caminho).
+    unsigned advance_in_slices(std::chrono::steady_clock::duration budget, bool *completed = nullptr) {
+        unsigned slices = 0;
+        uint64_t base = 0;
+        bool published = false, finished = false;
+        if (completed) {
+            *completed = false;
+        }
+        if (!run_request([&]() {
+                ++slices;
+                base = change_log.version();
+                published = finished = advance_slice(budget);
+            })) {
+            return 0;
+        }
+        while (!published) {
+            published = run([&]() {
+                ++slices;
+                if (change_log.version() != base) {
+                    return true;
+                }
+                return finished = advance_slice(budget);
+            });
+        }
+        if (completed) {
+            *completed = finished;
+        }
+        return slices;
+    }
+
+    // Descartar a iteração em andamento. Deve ser chamada no strand.
+    void clear_pending() {
+        pending.reset();
+        pending_bytes = 0;
+    }
+
+    // Avançar a simulação em até iterations iterações, enquanto keep_going (chamada depois
+    // de cada iteração, com a população) retornar true, e publicar o resultado uma vez.
+    // Deve ser chamada no strand, com um slot do escalonador. Retorna o número de
+    // iterações simuladas.
+    template <typename Continue>
+    uint64_t advance_while(uint64_t iterations, Continue &&keep_going) {
+        const auto started = std::chrono::steady_clock::now();
+        uint64_t done = 0;
+        changed_cells_t changed;
+        while (done < iterations) {
+            {
+                std::lock_guard<std::mutex> lock(mutex); // Bloquear o mutex durante a simulação
+                std::shared_ptr<const rules_t> current = std::atomic_load(&rules); // Regras novas valem a partir desta iteração
+                simulate_iteration(grid, gen, *current, &population, &changed);
+                ++tick;
+            }
+            ++done;
+            if (!keep_going(static_cast<const population_t &>(population))) {
+                break;
+            }
+        }
+        pacer.measure(done, std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+
+        // Publicar a nova versão para os clientes conectados
+        std::lock_guard<std::mutex> lock(mutex);
+        change_log.record(grid, next_publication_version(), changed);
+        publish();
+        return done;
+    }
+
+    // Descartar os lotes calculados de antemão que não continuam a publicação atual (o
+    // mundo foi recomeçado ou avançado por outro caminho) ou que usaram regras antigas
+    void discard_stale_speculation() {
+        if (!speculation.empty() && (speculation_base != change_log.version() || speculation.front().rules != std::atomic_load(&rules))) {
+            clear_speculation();
+        }
+    }
+
+    // Publicar o próximo lote calculado de antemão, se ele tiver iterations iterações (ou
+    // qualquer número, se iterations for 0). Retorna as iterações publicadas (0 se nenhuma).
+    unsigned take_speculation(unsigned iterations) {
+        discard_stale_speculation();
+        if (speculation.empty() || (iterations > 0 && speculation.front().iterations != iterations)) {
+            clear_speculation();
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        speculative_frame_t &frame = speculation.front();
+        const unsigned taken = frame.iterations;
+        grid = std::move(frame.grid);
+        gen = frame.gen;
+        population = frame.population;
+        tick += taken;
+        change_log.record(grid, next_publication_version(), frame.changed);
+        publish();
+        speculation.pop_front();
+        speculation_base = change_log.version();
+        speculation_bytes = speculation.size() * grid.size() * sizeof(entity_t);
+        return taken;
+    }
+
+    // Gravar o mundo em directory e liberar sua memória. O arquivo traz o estado do gerador
+    // (uint32 com o tamanho do texto, seguido do texto) e a grade em um quadro binário
+    // completo; as regras ficam em memória. Deve ser chamada no strand. Sessões com
+    // clientes WebSocket não são despejadas; retorna false se a sessão continua em memória.
+    bool spill(const std::string &directory) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!spill_path.empty() || push_hub.size() > 0) {
+            return false;
+        }
+
+        std::ostringstream state;
+        state << gen;
+        const frame_header_t header = current_header();
+        std::string contents;
+        put_frame_integer(contents, state.str().size(), 4);
+        contents += state.str();
+        contents += gridToFrame(grid, header);
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        const std::string path = directory + "/session-" + std::to_string(id) + ".ecof";
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (error || !file.write(contents.data(), contents.size()) || !file.flush()) {
+            std::remove(path.c_str());
+            return false;
+        }
+
+        spill_path = path;
+        spilled_header = header;
+        spilled_rows = grid.rows;
+        spilled_cols = grid.cols;
+        grid = grid_t();
+        clear_speculation();
+        clear_pending();
+        change_log.clear(header.version);
+        frame_cache.clear();
+        std::atomic_store(&snapshot, std::shared_ptr<const world_snapshot_t>());
+        resident_bytes = 0;
+        return true;
+    }
+
+    // Recarregar o mundo despejado, se houver, e publicá-lo com a mesma versão de antes
+    // (as ETags dos clientes continuam valendo). Se o arquivo sumiu ou não corresponde ao
+    // mundo gravado, a sessão recomeça com um mundo vazio das mesmas dimensões, em vez de
+    // ficar meio restaurada, e reload_error descreve o problema. Deve ser chamada no strand.
+    void reload() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spill_path.empty()) {
+            return;
+        }
+
+        grid_t loaded;
+        frame_header_t header;
+        std::mt19937 loaded_gen;
+        try {
+            std::ifstream file(spill_path, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("arquivo ausente");
+            }
+            const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            if (file.bad()) {
+                throw std::runtime_error("erro de leitura");
+            }
+            const size_t length = get_frame_integer(contents, 0, 4);
+            if (4 + length > contents.size()) {
+                throw std::invalid_argument("Quadro truncado");
+            }
+            std::istringstream state(contents.substr(4, length));
+            if (!(state >> loaded_gen)) {
+                throw std::invalid_argument("estado do gerador inválido");
+            }
+            frameToGrid(contents.substr(4 + length), loaded, header);
+            if (loaded.rows != spilled_rows || loaded.cols != spilled_cols || header.version != spilled_header.version) {
+                throw std::invalid_argument("o arquivo não corresponde ao mundo gravado");
+            }
+        } catch (const std::exception &error) {
+            std::remove(spill_path.c_str());
+            spill_path.clear();
+            grid = grid_t(spilled_rows, spilled_cols);
+            tick = 0;
+            seed = spilled_header.seed;
+            const changed_cells_t no_cells;
+            restart(population_t(), &no_cells);
+            reload_error = std::string("Não foi possível recarregar o mundo despejado (") + error.what() + "); a sessão recomeçou com um mundo vazio";
+            return;
+        }
+
+        grid = std::move(loaded);
+        gen = loaded_gen;
+        tick = header.tick;
+        seed = header.seed;
+        population = count_population(grid);
+        change_log.reset(grid, header.version);
+
+        std::remove(spill_path.c_str());
+        spill_path.clear();
+        publish();
+    }
+
+    // Resumo da sessão para a listagem
+    nlohmann::json describe() {
+        std::lock_guard<std::mutex> lock(mutex);
+        const bool resident = spill_path.empty();
+        const frame_header_t header = resident ? current_header() : spilled_header;
+        nlohmann::json result = {
+            { "id", id },
+            { "rows", resident ? grid.rows : spilled_rows },
+            { "cols", resident ? grid.cols : spilled_cols },
+            { "tick", header.tick },
+            { "version", header.version },
+            { "clients", push_hub.size() },
+            { "resident", resident },
+            { "memory", memory_bytes() },
+            { "ticks_per_frame", pacer.iterations() },
+            { "tick_cost", pacer.tick_seconds() },
+            { "frame_budget_ms", pacer.budget_ms() },
+            { "weight", account.weight.load() },
+            { "cpu", {
+                { "interactive", account.interactive_ns / 1e9 },
+                { "batch", account.batch_ns / 1e9 },
+                { "waited", account.waited_ns / 1e9 }
+            } }
+        };
+        if (!reload_error.empty()) {
+            result["error"] = reload_error;
+        }
+        return result;
+    }
+};
+
+class session_registry_t {
+public:
+    session_registry_t() = default;
+    session_registry_t(const session_registry_t &) = delete;
+    session_registry_t &operator=(const session_registry_t &) = delete;
+
+    ~session_registry_t() {
+        {
+            std::lock_guard<std::mutex> lock(eviction_mutex_);
+            stopping_ = true;
+        }
+        eviction_wake_.notify_all();
+        if (evictor_.joinable()) {
+            evictor_.join();
+        }
+    }
+
+    // Definir o orçamento de memória de todas as sessões, o diretório dos mundos despejados,
+    // o número máximo de sessões abertas e de pedidos esperando a vez em cada sessão, e
+    // começar a verificar o orçamento em segundo plano
+    void configure(size_t budget, const std::string &directory, size_t maximum_count = SESSION_DEFAULT_MAXIMUM_COUNT, size_t maximum_waiting = SESSION_DEFAULT_MAXIMUM_WAITING) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            maximum_count_ = std::max<size_t>(1, maximum_count);
+            maximum_waiting_ = maximum_waiting;
+        }
+        std::lock_guard<std::mutex> lock(eviction_mutex_);
+        budget_ = budget;
+        directory_ = directory;
+        if (!evictor_.joinable()) {
+            evictor_ = std::thread([this]() { evict_periodically(); });
+        }
+    }
+
+    // Criar uma sessão; ela só entra no registro depois de ter um mundo (vazio) publicado.
+    // Retorna nullptr, sem consumir um identificador, se o número máximo de sessões abertas
+    // já foi atingido (contando as que estão sendo criadas).
+    std::shared_ptr<session_t> create() {
+        std::shared_ptr<session_t> session;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (sessions_.size() + creating_ >= maximum_count_) {
+                return nullptr;
+            }
+            ++creating_;
+            session = std::make_shared<session_t>(next_id_++);
+            session->maximum_waiting = maximum_waiting_;
+        }
+        {
+            std::lock_guard<std::mutex> lock(session->mutex);
+            const changed_cells_t no_cells;
+            session->restart(population_t(), &no_cells);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        --creating_;
+        sessions_[session->id] = session;
+        return session;
+    }
+
+    std::shared_ptr<session_t> find(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sessions_.find(id);
+        return it == sessions_.end() ? nullptr : it->second;
+    }
+
+    // Encerrar uma sessão; quem ainda a usa mantém o objeto até terminar
+    bool remove(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sessions_.erase(id) > 0;
+    }
+
+    std::vector<std::shared_ptr<session_t>> list() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::shared_ptr<session_t>> sessions;
+        for (auto &entry : sessions_) {
+            sessions.push_back(entry.second);
+        }
+        return sessions;
+    }
+
+    // Se a memória de todas as sessões passou do orçamento, despejar as usadas há mais
+    // tempo até que o total caia a SESSION_EVICTION_TARGET_PERCENT do orçamento. Sessões
+    // ocupadas (com pedidos no strand), usadas há menos de SESSION_EVICTION_MINIMUM_IDLE_MS
+    // ou usadas por último ficam em memória. Chamada pela thread de despejo, fora do
+    // caminho dos pedidos.
+    void enforce_budget() {
+        std::lock_guard<std::mutex> lock(enforce_mutex_);
+        size_t budget;
+        std::string directory;
+        {
+            std::lock_guard<std::mutex> config_lock(eviction_mutex_);
+            budget = budget_;
+            directory = directory_;
+        }
+
+        std::vector<std::pair<std::shared_ptr<session_t>, size_t>> candidates;
+        size_t total = 0;
+        for (std::shared_ptr<session_t> &session : list()) {
+            const size_t bytes = session->memory_bytes();
+            total += bytes;
+            candidates.emplace_back(std::move(session), bytes);
+        }
+        if (total <= budget || candidates.empty()) {
+            return;
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+            return a.first->last_access < b.first->last_access;
+        });
+        candidates.pop_back(); // a sessão usada por último nunca é despejada
+        const size_t target = budget / 100 * SESSION_EVICTION_TARGET_PERCENT;
+        const int64_t idle_since = session_clock_ms() - SESSION_EVICTION_MINIMUM_IDLE_MS;
+        for (auto &candidate : candidates) {
+            if (total <= target || candidate.first->last_access > idle_since) {
+                break;
+            }
+            bool spilled = false;
+            candidate.first->strand.try_run([&]() { spilled = candidate.first->spill(directory); });
+            if (spilled) {
+                total -= std::min(total, candidate.second);
+            }
+        }
+    }
+
+private:
+    // Verificar o orçamento a cada SESSION_EVICTION_INTERVAL até o registro ser destruído
+    void evict_periodically() {
+        std::unique_lock<std::mutex> lock(eviction_mutex_);
+        while (!eviction_wake_.wait_for(lock, SESSION_EVICTION_INTERVAL, [this]() { return stopping_; })) {
+            lock.unlock();
+            enforce_budget();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::map<uint64_t, std::shared_ptr<session_t>> sessions_;
+    size_t creating_ = 0; // sessões sendo criadas, já contadas no limite; protegido por mutex_
+    std::atomic<uint64_t> next_id_{ 1 };
+    std::mutex enforce_mutex_;
+    std::mutex eviction_mutex_; // configuração e parada da thread de despejo
+    std::condition_variable eviction_wake_;
+    bool stopping_ = false;
+    std::thread evictor_;
+    size_t maximum_count_ = SESSION_DEFAULT_MAXIMUM_COUNT; // protegido por mutex_
+    size_t maximum_waiting_ = SESSION_DEFAULT_MAXIMUM_WAITING; // protegido por mutex_
+    size_t budget_ = SESSION_DEFAULT_MEMORY_BUDGET;
+    std::string directory_ = (std::filesystem::temp_directory_path() / "ecosim-sessions").string();
+};
@@ -0,0 +1,537 @@
+#pragma once
+
+#include "entity.h"
+#include "placement.h"
+#include "rules.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Defina o armazenamento das células da grade: um bloco obtido com calloc. Uma célula
+// vazia tem todos os bytes zerados, então um bloco novo já é uma grade vazia sem que
+// nenhuma célula seja escrita; em grades grandes o bloco vem de páginas novas do sistema,
+// que só são zeradas quando tocadas. As cópias também partem de um bloco zerado e só
+// copiam os trechos com alguma entidade, então recomeçar um mundo custa o número de
+// entidades posicionadas, e não o número de células.
+class cell_buffer_t {
+public:
+    // Número de células de um trecho pulado inteiro quando vazio
+    static constexpr size_t CELL_BLOCK = 1024;
+
+    cell_buffer_t() = default;
+
+    explicit cell_buffer_t(size_t size) : size_(size) {
+        static_assert(entity_type::empty == 0, "a célula vazia deve ter todos os bytes zerados");
+        if (size_ > 0 && !(data_ = static_cast<entity_t *>(std::calloc(size_, sizeof(entity_t))))) {
+            throw std::bad_alloc();
+        }
+    }
+
+    cell_buffer_t(const cell_buffer_t &other) : cell_buffer_t(other.size_) {
+        for (size_t first = 0; first < size_; first += CELL_BLOCK) {
+            if (!other.blank(first)) {
+                std::memcpy(data_ + first, other.data_ + first, block_size(first) * sizeof(entity_t));
+            }
+        }
+    }
+
+    cell_buffer_t(cell_buffer_t &&other) noexcept {
+        swap(other);
+    }
+
+    cell_buffer_t &operator=(cell_buffer_t other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~cell_buffer_t() {
+        std::free(data_);
+    }
+
+    void swap(cell_buffer_t &other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+    // Número de células do trecho que começa em first
+    size_t block_size(size_t first) const {
+        return std::min(CELL_BLOCK, size_ - first);
+    }
+
+    // Se todas as células do trecho que começa em first estão vazias
+    bool blank(size_t first) const {
+        static const entity_t zeros[CELL_BLOCK] = {};
+        return std::memcmp(data_ + first, zeros, block_size(first) * sizeof(entity_t)) == 0;
+    }
+
+    entity_t *data() { return data_; }
+    const entity_t *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    entity_t &operator[](size_t cell) { return data_[cell]; }
+    const entity_t &operator[](size_t cell) const { return data_[cell]; }
+    entity_t *begin() { return data_; }
+    entity_t *end() { return data_ + size_; }
+    const entity_t *begin() const { return data_; }
+    const entity_t *end() const { return data_ + size_; }
+
+private:
+    entity_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Defina a grade de entidades: as células ficam linha a linha em um único bloco,
+// e grid[i][j] continua endereçando a linha i, coluna j
+struct grid_t {
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    cell_buffer_t cells;
+
+    grid_t() = default;
+    grid_t(uint32_t rows, uint32_t cols) : rows(rows), cols(cols), cells(static_cast<size_t>(rows) * cols) {}
+
+    entity_t *operator[](size_t i) {
+        return cells.data() + i * cols;
+    }
+
+    const entity_t *operator[](size_t i) const {
+        return cells.data() + i * cols;
+    }
+
+    size_t size() const {
+        return cells.size();
+    }
+};
+
+// Defina uma estrutura para contar a população de cada espécie
+struct population_t {
+    uint32_t plants = 0;
+    uint32_t herbivores = 0;
+    uint32_t carnivores = 0;
+};
+
+// Função para gerar um número inteiro aleatório entre min e max
+inline int random_integer(std::mt19937 &gen, int min, int max) {
+    std::uniform_int_distribution<int> distribution(min, max);
+    return distribution(gen);
+}
+
+// Função para gerar um número de ponto flutuante aleatório entre 0 e 1
+inline double random_action(std::mt19937 &gen, double probability) {
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    return distribution(gen) < probability;
+}
+
+// Função para contar a população de cada espécie na grade
+inline population_t count_population(const grid_t &grid) {
+    population_t population;
+    for (size_t first = 0; first < grid.size(); first += cell_buffer_t::CELL_BLOCK) {
+        if (grid.cells.blank(first)) {
+            continue;
+        }
+        for (size_t cell = first; cell < first + grid.cells.block_size(first); ++cell) {
+            const entity_t &entity = grid.cells[cell];
+            population.plants += entity.type == plant;
+            population.herbivores += entity.type == herbivore;
+            population.carnivores += entity.type == carnivore;
+        }
+    }
+    return population;
+}
+
+// Função para atualizar a contagem da população (se houver) quando uma célula passa do
+// tipo before para o tipo after
+inline void count_change(population_t *population, entity_type before, entity_type after) {
+    if (!population || before == after) {
+        return;
+    }
+    uint32_t *counts[4] = { nullptr, &population->plants, &population->herbivores, &population->carnivores };
+    if (counts[before]) {
+        --*counts[before];
+    }
+    if (counts[after]) {
+        ++*counts[after];
+    }
+}
+
+// Defina o registro das células escritas na grade nova durante uma ou mais etapas de tempo.
+// Os índices ficam sem ordem e podem se repetir; quando passariam do número de células da
+// grade, o registro desiste de guardá-los e marca overflow (qualquer célula pode ter mudado).
+struct changed_cells_t {
+    std::vector<uint32_t> cells;
+    bool overflow = false;
+
+    void clear() {
+        cells.clear();
+        overflow = false;
+    }
+};
+
+// Função para registrar (se houver registro) uma escrita na célula cell de uma grade com
+// num_cells células
+inline void mark_change(changed_cells_t *changed, size_t cell, size_t num_cells) {
+    if (!changed || changed->overflow) {
+        return;
+    }
+    if (changed->cells.size() >= num_cells) {
+        changed->overflow = true;
+        std::vector<uint32_t>().swap(changed->cells);
+        return;
+    }
+    changed->cells.push_back(static_cast<uint32_t>(cell));
+}
+
+// Função para posicionar as entidades iniciais em células vazias aleatórias de uma grade vazia.
+// As células são sorteadas sem repetição, com custo linear no número de entidades. Se placed
+// for informado, recebe o índice de cada célula preenchida.
+inline void populate_grid(grid_t &grid, std::mt19937 &gen, const rules_t &rules, uint32_t num_plants, uint32_t num_herbivores, uint32_t num_carnivores, changed_cells_t *placed = nullptr) {
+    cell_sampler_t sampler(grid.size(), (uint64_t)num_plants + num_herbivores + num_carnivores);
+    const entity_type types[3] = { plant, herbivore, carnivore };
+    const uint32_t counts[3] = { num_plants, num_herbivores, num_carnivores };
+
+    for (int species = 0; species < 3; ++species) {
+        for (uint32_t i = 0; i < counts[species]; ++i) {
+            const size_t cell = sampler.next(gen);
+            grid.cells[cell] = { types[species], rules.maximum_energy, 0 };
+            mark_change(placed, cell, grid.size());
+        }
+    }
+}
+
+// Função para simular as linhas [first_row, last_row) de uma etapa de tempo: lê e altera
+// grid (que começa como a grade anterior) e escreve o resultado em new_entity_grid (que
+// começa como uma cópia dela). Simular todas as linhas em ordem, em uma ou mais chamadas,
+// equivale a uma etapa. Se population for informada, ela é atualizada a cada célula
+// alterada em new_entity_grid; se changed for informado, recebe o índice de cada célula
+// escrita em new_entity_grid.
+inline void simulate_rows(grid_t &grid, grid_t &new_entity_grid, std::mt19937 &gen, const rules_t &rules, uint32_t first_row, uint32_t last_row, population_t *population = nullptr, changed_cells_t *changed = nullptr) {
+    const uint32_t rows = grid.rows;
+    const uint32_t cols = grid.cols;
+    const size_t num_cells = grid.size();
+
+    for (uint32_t i = first_row; i < last_row; ++i) {
+        for (uint32_t j = 0; j < cols; ++j) {
+            entity_t &current_entity = grid[i][j];
+            entity_t &new_entity = new_entity_grid[i][j];
+
+            // Implementar a lógica de comportamento apropriada para cada tipo de entidade
+            switch (current_entity.type) {
+                case empty:
+                    // Célula vazia, nenhuma ação necessária
+                    break;
+                case plant:
+                    // Lógica para plantas (por exemplo, crescimento, reprodução)
+                    if (random_action(gen, rules.plant_reproduction_probability)) {
+                        std::vector<pos_t> empty_adjacent_cells;
+                        if (i > 0 && grid[i - 1][j].type == empty) {
+                            empty_adjacent_cells.push_back({ i - 1, j });
+                        }
+                        if (i < rows - 1 && grid[i + 1][j].type == empty) {
+                            empty_adjacent_cells.push_back({ i + 1, j });
+                        }
+                        if (j > 0 && grid[i][j - 1].type == empty) {
+                            empty_adjacent_cells.push_back({ i, j - 1 });
+                        }
+                        if (j < cols - 1 && grid[i][j + 1].type == empty) {
+                            empty_adjacent_cells.push_back({ i, j + 1 });
+                        }
+
+                        if (!empty_adjacent_cells.empty()) {
+                            std::uniform_int_distribution<size_t> rand_empty_cell(0, empty_adjacent_cells.size() - 1);
+                            size_t chosen_index = rand_empty_cell(gen);
+                            pos_t new_plant_pos = empty_adjacent_cells[chosen_index];
+                            count_change(population, new_entity_grid[new_plant_pos.i][new_plant_pos.j].type, plant);
+                            mark_change(changed, static_cast<size_t>(new_plant_pos.i) * cols + new_plant_pos.j, num_cells);
+                            new_entity_grid[new_plant_pos.i][new_plant_pos.j].type = plant;
+                        }
+                    }
+                    break;
+                case herbivore:
+                    // Lógica para herbívoros (por exemplo, movimento, alimentação, reprodução)
+                    if (random_action(gen, rules.herbivore_move_probability)) {
+                        // Herbívoro se move
+                        int current_i = static_cast<int>(i);
+                        int current_j = static_cast<int>(j);
+                        std::vector<pos_t> possible_moves;
+
+                        if (current_i > 0 && grid[current_i - 1][current_j].type == empty) {
+                            possible_moves.push_back({current_i - 1, current_j}); // Mover para cima
+                        }
+                        if (current_i < rows - 1 && grid[current_i + 1][current_j].type == empty) {
+                            possible_moves.push_back({current_i + 1, current_j}); // Mover para baixo
+                        }
+                        if (current_j > 0 && grid[current_i][current_j - 1].type == empty) {
+                            possible_moves.push_back({current_i, current_j - 1}); // Mover para a esquerda
+                        }
+                        if (current_j < cols - 1 && grid[current_i][current_j + 1].type == empty) {
+                            possible_moves.push_back({current_i, current_j + 1}); // Mover para a direita
+                        }
+
+                        if (!possible_moves.empty()) {
+                            int random_index = random_integer(gen, 0, possible_moves.size() - 1);
+                            int new_i = possible_moves[random_index].i;
+                            int new_j = possible_moves[random_index].j;
+
+                            count_change(population, new_entity_grid[new_i][new_j].type, current_entity.type);
+                            mark_change(changed, static_cast<size_t>(new_i) * cols + new_j, num_cells);
+                            new_entity_grid[new_i][new_j] = current_entity;
+                            count_change(population, new_entity_grid[current_i][current_j].type, empty);
+                            mark_change(changed, static_cast<size_t>(current_i) * cols + current_j, num_cells);
+                            new_entity_grid[current_i][current_j].type = empty;
+                        }
+                    }
+
+                    if (random_action(gen, rules.herbivore_eat_probability)) {
+                        // Herbívoro tenta comer uma planta
+                       int current_i = static_cast<int>(i);
+                        int current_j = static_cast<int>(j);
+                        for (int direction = 0; direction < 4; ++direction) {
+                            int new_i = current_i;
+                            int new_j = current_j;
+
+                            switch (direction) {
+                                case 0:
+                                    if (current_i > 0) {
+                                        new_i = current_i - 1;
+                                    }
+                                    break;
+                                case 1:
+                                    if (current_i < rows - 1) {
+                                        new_i = current_i + 1;
+                                    }
+                                    break;
+                                case 2:
+                                    if (current_j > 0) {
+                                        new_j = current_j - 1;
+                                    }
+                                    break;
+                                case 3:
+                                    if (current_j < cols - 1) {
+                                        new_j = current_j + 1;
+                                    }
+                                    break;
+                            }
+
+                            if (grid[new_i][new_j].type == plant) {
+                                grid[new_i][new_j].type = empty;
+                                current_entity.energy += 30;
+                            }
+                        }
+                    }
+
+                    if (random_action(gen, rules.herbivore_reproduction_probability)) {
+                        // Herbívoro tenta se reproduzir
+                        if (current_entity.energy > rules.threshold_energy_for_reproduction) {
+                            for (int direction = 0; direction < 4; ++direction) {
+                                int new_i = i;
+                                int new_j = j;
+
+                                switch (direction) {
+                                    case 0:
+                                        if (i > 0) {
+                                            new_i = i - 1;
+                                        }
+                                        break;
+                                    case 1:
+                                        if (i < rows - 1) {
+                                            new_i = i + 1;
+                                        }
+                                        break;
+                                    case 2:
+                                        if (j > 0) {
+                                            new_j = j - 1;
+                                        }
+                                        break;
+                                    case 3:
+                                        if (j < cols - 1) {
+                                            new_j = j + 1;
+                                        }
+                                        break;
+                                }
+
+                                if (grid[new_i][new_j].type == empty) {
+                                    grid[new_i][new_j].type = herbivore;
+                                    grid[new_i][new_j].energy = rules.herbivore_initial_energy;
+                                    grid[new_i][new_j].age = rules.herbivore_initial_age;
+                                    current_entity.energy -= 10;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                    break;
+                case carnivore:
+                    // Lógica para carnívoros (por exemplo, movimento, alimentação, reprodução)
+                    if (random_action(gen, rules.carnivore_move_probability)) {
+                        int random_direction = random_integer(gen, 0, 3);
+                        int new_i = i;
+                        int new_j = j;
+
+                        switch (random_direction) {
+                            case 0:
+                                if (i > 0) {
+                                    new_i = i - 1;
+                                }
+                                break;
+                            case 1:
+                                if (i < rows - 1) {
+                                    new_i = i + 1;
+                                }
+                                break;
+                            case 2:
+                                if (j > 0) {
+                                    new_j = j - 1;
+                                }
+                                break;
+                            case 3:
+                                if (j < cols - 1) {
+                                    new_j = j + 1;
+                                }
+                                break;
+                        }
+
+                        if (grid[new_i][new_j].type == herbivore) {
+                            grid[new_i][new_j] = current_entity;
+                            grid[i][j].type = empty;
+                        }
+                    }
+
+                    if (random_action(gen, rules.carnivore_eat_probability)) {
+                        int random_direction = random_integer(gen, 0, 3);
+                        int new_i = i;
+                        int new_j = j;
+
+                        switch (random_direction) {
+                            case 0:
+                                if (i > 0) {
+                                    new_i = i - 1;
+                                }
+                                break;
+                            case 1:
+                                if (i < rows - 1) {
+                                    new_i = i + 1;
+                                }
+                                break;
+                            case 2:
+                                if (j > 0) {
+                                    new_j = j - 1;
+                                }
+                                break;
+                            case 3:
+                                if (j < cols - 1) {
+                                    new_j = j + 1;
+                                }
+                                break;
+                        }
+
+                        if (grid[new_i][new_j].type == herbivore) {
+                            grid[new_i][new_j].type = empty;
+                            current_entity.energy += 50;
+                        }
+                    }
+
+                    if (random_action(gen, rules.carnivore_reproduction_probability)) {
+                        if (current_entity.energy > rules.threshold_energy_for_reproduction) {
+                            for (int direction = 0; direction < 4; ++direction) {
+                                int new_i = i;
+                                int new_j = j;
+
+                                switch (direction) {
+                                    case 0:
+                                        if (i > 0) {
+                                            new_i = i - 1;
+                                        }
+                                        break;
+                                    case 1:
+                                        if (i < rows - 1) {
+                                            new_i = i + 1;
+                                        }
+                                        break;
+                                    case 2:
+                                        if (j > 0) {
+                                            new_j = j - 1;
+                                        }
+                                        break;
+                                    case 3:
+                                        if (j < cols - 1) {
+                                            new_j = j + 1;
+                                        }
+                                        break;
+                                }
+
+                                if (grid[new_i][new_j].type == empty) {
+                                    grid[new_i][new_j].type = carnivore;
+                                    grid[new_i][new_j].energy = rules.carnivore_initial_energy;
+                                    grid[new_i][new_j].age = rules.carnivore_initial_age;
+                                    current_entity.energy -= 20;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                    break;
+            }
+
+            // Atualizar a idade e energia da entidade
+            current_entity.age++;
+            current_entity.energy--;
+
+            if (current_entity.energy <= 0) {
+                // A entidade morre se sua energia for esgotada
+                count_change(population, new_entity_grid[i][j].type, empty);
+                mark_change(changed, static_cast<size_t>(i) * cols + j, num_cells);
+                new_entity_grid[i][j] = { empty, 0, 0 };
+            }
+        }
+    }
+}
+
+// Função para avançar a grade de entidades por uma etapa de tempo. Se population for
+// informada (com a contagem da grade atual), ela é atualizada a cada célula alterada, sem
+// percorrer a grade de novo; se changed for informado, recebe as células escritas.
+inline void simulate_iteration(grid_t &grid, std::mt19937 &gen, const rules_t &rules, population_t *population = nullptr, changed_cells_t *changed = nullptr) {
+    grid_t new_entity_grid = grid;
+    simulate_rows(grid, new_entity_grid, gen, rules, 0, grid.rows, population, changed);
+
+    // Atualizar a grade de entidades com a cópia temporária
+    grid = std::move(new_entity_grid);
+}
+
+// Defina uma etapa de tempo simulada em fatias que podem ser retomadas. Ela trabalha sobre
+// cópias da grade e do gerador, de modo que a grade original continua intacta (e legível)
+// até a etapa terminar; o resultado fica em next, gen, population e changed.
+struct sliced_iteration_t {
+    sliced_iteration_t(const grid_t &grid, const std::mt19937 &gen, const population_t &population, std::shared_ptr<const rules_t> rules)
+        : grid(grid), next(grid), gen(gen), population(population), rules(std::move(rules)) {}
+
+    grid_t grid;  // grade no início da etapa, alterada no lugar pela simulação
+    grid_t next;  // grade ao fim da etapa
+    std::mt19937 gen;
+    population_t population;
+    changed_cells_t changed;
+    std::shared_ptr<const rules_t> rules;
+    uint32_t row = 0;      // próxima linha a simular
+    double seconds = 0;    // tempo gasto nas fatias até agora
+
+    bool done() const {
+        return row >= grid.rows;
+    }
+
+    // Simular linhas até terminar a etapa ou passar do prazo (pelo menos uma linha por
+    // chamada). Retorna true quando a etapa está completa.
+    bool resume(std::chrono::steady_clock::time_point deadline) {
+        const auto started = std::chrono::steady_clock::now();
+        do {
+            simulate_rows(grid, next, gen, *rules, row, row + 1, &population, &changed);
+            ++row;
+        } while (!done() && std::chrono::steady_clock::now() < deadline);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return done();
+    }
+};
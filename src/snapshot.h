@@ -0,0 +1,140 @@
+#pragma once
+
+#include "delta.h"
+#include "frame.h"
+#include "pyramid.h"
+#include "simulation.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Número de publicações seguidas sem leitura da pirâmide depois das quais a sessão deixa
+// de mantê-la (ela volta a ser montada no próximo pedido)
+static const uint32_t PYRAMID_IDLE_PUBLICATIONS = 64;
+
+// Defina uma publicação imutável da grade. Cada publicação (início do mundo ou lote de
+// iterações) gera um novo objeto, trocado de forma atômica; os leitores usam o último
+// sem bloquear a simulação.
+struct world_snapshot_t {
+    grid_t grid;
+    frame_header_t header;
+
+    world_snapshot_t(const grid_t &grid, const frame_header_t &header) : grid(grid), header(header) {}
+
+    // Montar a publicação de uma grade que partiu vazia copiando só as células listadas:
+    // as demais já estão vazias no bloco novo, que não precisa ser percorrido
+    world_snapshot_t(const grid_t &source, const frame_header_t &header, const std::vector<uint32_t> &cells) : grid(source.rows, source.cols), header(header) {
+        for (uint32_t cell : cells) {
+            grid.cells[cell] = source.cells[cell];
+        }
+    }
+
+    // Pirâmide de resumos da publicação: mantida a partir da publicação anterior ou, se
+    // ela não tinha uma, montada no primeiro pedido
+    const pyramid_t &pyramid() const {
+        std::call_once(pyramid_once_, [this]() {
+            if (!pyramid_) {
+                pyramid_ = std::make_shared<const pyramid_t>(build_pyramid(grid));
+                pyramid_bytes_ = pyramid_memory_bytes(*pyramid_);
+                pyramid_ready_ = true;
+            }
+        });
+        pyramid_read_ = true;
+        return *pyramid_;
+    }
+
+    // Derivar a pirâmide da publicação anterior, antes de publicar esta: copiar a dela e
+    // refazer só os blocos das células alteradas desde então (ou montá-la de novo, se
+    // mudaram muitas células ou o registro não as cobre). Só é feito enquanto a pirâmide
+    // continua sendo lida, de modo que servir blocos custa o tamanho das alterações, e não
+    // do mundo, a cada publicação.
+    void follow_pyramid(const world_snapshot_t *previous, const change_log_t &change_log) {
+        if (!previous || !previous->pyramid_ready_) {
+            return;
+        }
+        const uint32_t idle = previous->pyramid_read_ ? 0 : previous->pyramid_idle_ + 1;
+        if (idle > PYRAMID_IDLE_PUBLICATIONS) {
+            return;
+        }
+
+        std::vector<uint32_t> cells;
+        std::shared_ptr<const pyramid_t> source = previous->pyramid_;
+        if (previous->grid.rows == grid.rows && previous->grid.cols == grid.cols && change_log.changes_since(previous->header.version, cells) && cells.size() < source->levels.front().blocks.size()) {
+            auto pyramid = std::make_shared<pyramid_t>(*source);
+            update_pyramid(*pyramid, grid, cells);
+            pyramid_ = std::move(pyramid);
+        } else {
+            pyramid_ = std::make_shared<const pyramid_t>(build_pyramid(grid));
+        }
+        pyramid_bytes_ = pyramid_memory_bytes(*pyramid_);
+        pyramid_idle_ = idle;
+        pyramid_ready_ = true;
+    }
+
+    // Memória ocupada pela publicação (grade e pirâmide, se já montada), em bytes
+    size_t memory_bytes() const {
+        return grid.size() * sizeof(entity_t) + pyramid_bytes_;
+    }
+
+private:
+    mutable std::once_flag pyramid_once_;
+    mutable std::shared_ptr<const pyramid_t> pyramid_;
+    mutable std::atomic<size_t> pyramid_bytes_{ 0 };
+    mutable std::atomic<bool> pyramid_ready_{ false }; // pyramid_ pode ser lida por outras threads
+    mutable std::atomic<bool> pyramid_read_{ false };
+    uint32_t pyramid_idle_ = 0;
+};
+
+// Defina uma região retangular da grade: coluna x, linha y, largura w e altura h
+struct region_t {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t w = 0;
+    uint32_t h = 0;
+
+    // Identificador da região, usado como chave de cache e na ETag
+    std::string key() const {
+        return std::to_string(x) + "," + std::to_string(y) + "," + std::to_string(w) + "," + std::to_string(h);
+    }
+};
+
+// Função para ler um parâmetro inteiro obrigatório da região
+inline uint32_t region_parameter(const char *value, const char *name) {
+    char *end = nullptr;
+    unsigned long number = value ? std::strtoul(value, &end, 10) : 0;
+    if (!value || *end != '\0' || number > MAXIMUM_GRID_SIZE) {
+        throw std::invalid_argument(std::string("Parâmetro de região inválido: ") + name);
+    }
+    return static_cast<uint32_t>(number);
+}
+
+// Função para ler a região dos parâmetros ?x=&y=&w=&h= sobre uma grade de rows x cols;
+// a parte que passa da borda é descartada
+inline region_t regionFromQuery(const char *x, const char *y, const char *w, const char *h, uint32_t rows, uint32_t cols) {
+    region_t region;
+    region.x = region_parameter(x, "x");
+    region.y = region_parameter(y, "y");
+    region.w = region_parameter(w, "w");
+    region.h = region_parameter(h, "h");
+    if (region.x >= cols || region.y >= rows || region.w == 0 || region.h == 0) {
+        throw std::invalid_argument("A região está fora da grade");
+    }
+    region.w = std::min(region.w, cols - region.x);
+    region.h = std::min(region.h, rows - region.y);
+    return region;
+}
+
+// Função para copiar uma região da grade, linha a linha (custo proporcional à região)
+inline grid_t extract_region(const grid_t &grid, const region_t &region) {
+    grid_t part(region.h, region.w);
+    for (uint32_t i = 0; i < region.h; ++i) {
+        const entity_t *row = grid[region.y + i] + region.x;
+        std::copy(row, row + region.w, part[i]);
+    }
+    return part;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "session.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+// Cálculo antecipado dos próximos lotes de iterações das sessões interativas.
+//
+// Depois de cada quadro entregue, o serviço calcula os lotes seguintes em um anel limitado
+// (SPECULATION_DEPTH lotes, até SPECULATION_MAXIMUM_BYTES por sessão) enquanto o cliente
+// está ocioso; o próximo /next-iteration só publica o lote pronto e codifica o quadro. Cada
+// lote é calculado no strand da sessão, apenas quando não há pedidos esperando. Os lotes são
+// descartados quando o mundo é recomeçado ou avançado por outro caminho (jobs, avanço
+// rápido) e quando as regras mudam.
+
+// Defina o serviço de cálculo antecipado: um conjunto limitado de threads, separado das
+// threads do servidor
+class speculation_service_t {
+public:
+    explicit speculation_service_t(unsigned num_threads = std::max(1u, std::thread::hardware_concurrency() / 2)) : pool_(num_threads) {}
+
+    // Calcular de antemão os próximos lotes de iterations iterações da sessão (0 deixa o
+    // pacer escolher), se nenhuma tarefa já estiver fazendo isso. Para ao encher o anel ou
+    // quando chega um pedido.
+    void schedule(const std::shared_ptr<session_t> &session, unsigned iterations = 0) {
+        if (session->speculating.exchange(true)) {
+            return;
+        }
+        std::weak_ptr<session_t> weak = session;
+        pool_.submit([weak, iterations]() {
+            std::shared_ptr<session_t> session = weak.lock();
+            if (!session) {
+                return;
+            }
+            bool more = true;
+            while (more && session->strand.try_run([&]() { more = session->speculate(iterations); })) {
+            }
+            session->speculating = false;
+        });
+    }
+
+private:
+    thread_pool_t pool_;
+};
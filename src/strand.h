@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Defina um executor serial (strand): as tarefas enviadas rodam uma de cada vez, na ordem
+// de chegada, na própria thread que as enviou. Cada sessão tem o seu, de modo que os
+// pedidos para um mesmo mundo são ordenados enquanto mundos diferentes rodam em paralelo
+// nas threads do servidor. Como quem espera a vez ocupa a sua thread, os pedidos de
+// clientes entram por run_bounded, que limita quantos podem esperar no mesmo strand.
+class strand_t {
+public:
+    // Executar a tarefa quando chegar sua vez e retornar o seu resultado
+    template <typename Task>
+    auto run(Task &&task) -> decltype(task()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            const uint64_t ticket = next_ticket_++;
+            turn_.wait(lock, [&]() { return serving_ == ticket; });
+        }
+        return run_turn(task);
+    }
+
+    // Executar a tarefa quando chegar sua vez, se no máximo maximum_waiting tarefas já
+    // estiverem esperando atrás da que está rodando; retorna false, sem executá-la, caso contrário
+    template <typename Task>
+    bool run_bounded(uint64_t maximum_waiting, Task &&task) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (next_ticket_ - serving_ > maximum_waiting) {
+                return false;
+            }
+            const uint64_t ticket = next_ticket_++;
+            turn_.wait(lock, [&]() { return serving_ == ticket; });
+        }
+        run_turn(task);
+        return true;
+    }
+
+    // Executar a tarefa apenas se o strand estiver livre (sem tarefas rodando ou na fila);
+    // retorna false, sem executá-la, caso contrário
+    template <typename Task>
+    bool try_run(Task &&task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (serving_ != next_ticket_) {
+                return false;
+            }
+            ++next_ticket_;
+        }
+        run_turn(task);
+        return true;
+    }
+
+private:
+    // Executar a tarefa na vez já obtida e passá-la adiante, mesmo se a tarefa lançar uma exceção
+    template <typename Task>
+    auto run_turn(Task &task) -> decltype(task()) {
+        struct release_t {
+            strand_t &strand;
+            ~release_t() {
+                std::lock_guard<std::mutex> lock(strand.mutex_);
+                ++strand.serving_;
+                strand.turn_.notify_all();
+            }
+        } release{ *this };
+        return task();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable turn_;
+    uint64_t next_ticket_ = 0;
+    uint64_t serving_ = 0;
+};
@@ -0,0 +1,329 @@
+#pragma once
+
+#include "json.hpp"
+#include "rules.h"
+#include "simulation.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Limites aceitos pelo serviço de varredura de parâmetros
+static const size_t MAXIMUM_SWEEP_RUNS = 100000;
+static const size_t MAXIMUM_SWEEP_JOBS = 32;
+static const size_t MAXIMUM_ACTIVE_SWEEPS = 8;
+static const uint64_t MAXIMUM_SWEEP_ITERATIONS = 10000000;
+
+// Defina a especificação de uma varredura: cenário inicial, pontos do espaço de parâmetros e critérios de parada
+struct sweep_spec_t {
+    uint32_t plants = 0;
+    uint32_t herbivores = 0;
+    uint32_t carnivores = 0;
+    uint32_t replicates = 1;
+    uint64_t max_iterations = 10000;
+    uint32_t steady_window = 100;
+    uint64_t seed = 0;
+
+    // Regras completas de cada ponto e os valores varridos que o identificam
+    std::vector<rules_t> points;
+    std::vector<nlohmann::json> parameters;
+};
+
+// Defina o estado de um job de varredura, compartilhado entre as threads de execução e os handlers HTTP
+struct sweep_job_t {
+    uint64_t id = 0;
+    size_t total = 0;
+    std::atomic<bool> cancelled{ false };
+
+    std::mutex mutex;
+    std::condition_variable updated;
+    std::vector<nlohmann::json> results; // resumos na ordem em que as execuções terminam
+};
+
+// Função para ler a lista de valores de um parâmetro na grade cartesiana
+inline std::vector<double> sweep_values(const std::string &name, const nlohmann::json &values) {
+    if (!values.is_array() || values.empty()) {
+        throw std::invalid_argument("A grade do parâmetro " + name + " deve ser uma lista não vazia");
+    }
+    std::vector<double> result;
+    for (const auto &value : values) {
+        if (!value.is_number()) {
+            throw std::invalid_argument("Valor inválido na grade do parâmetro " + name);
+        }
+        result.push_back(value.get<double>());
+    }
+    return result;
+}
+
+// Função para converter a requisição JSON em uma especificação de varredura
+inline sweep_spec_t sweepSpecFromJson(const nlohmann::json &request_body) {
+    sweep_spec_t spec;
+    spec.plants = request_body.value("plants", 0u);
+    spec.herbivores = request_body.value("herbivores", 0u);
+    spec.carnivores = request_body.value("carnivores", 0u);
+    spec.replicates = request_body.value("replicates", 1u);
+    spec.max_iterations = request_body.value("max_iterations", (uint64_t)10000);
+    spec.steady_window = request_body.value("steady_window", 100u);
+    spec.seed = request_body.value("seed", (uint64_t)std::random_device{}());
+
+    if ((uint64_t)spec.plants + spec.herbivores + spec.carnivores > NUM_ROWS * NUM_ROWS) {
+        throw std::invalid_argument("Muitas entidades");
+    }
+    if (spec.replicates == 0 || spec.max_iterations == 0 || spec.max_iterations > MAXIMUM_SWEEP_ITERATIONS) {
+        throw std::invalid_argument("Número de réplicas ou iterações inválido");
+    }
+
+    const rules_t base = rulesFromJson(request_body.value("rules", nlohmann::json::object()));
+
+    if (request_body.contains("grid") && request_body.contains("latin_hypercube")) {
+        throw std::invalid_argument("Use apenas um entre grid e latin_hypercube");
+    }
+
+    if (request_body.contains("grid")) {
+        // Produto cartesiano dos valores de cada parâmetro
+        const nlohmann::json &grid = request_body["grid"];
+        if (!grid.is_object()) {
+            throw std::invalid_argument("grid deve ser um objeto");
+        }
+        spec.points.push_back(base);
+        spec.parameters.push_back(nlohmann::json::object());
+        for (auto it = grid.begin(); it != grid.end(); ++it) {
+            const rule_field_t *field = find_rule_field(it.key());
+            if (!field) {
+                throw std::invalid_argument("Regra desconhecida: " + it.key());
+            }
+            std::vector<double> values = sweep_values(it.key(), it.value());
+            if (spec.points.size() * values.size() * spec.replicates > MAXIMUM_SWEEP_RUNS) {
+                throw std::invalid_argument("Varredura grande demais");
+            }
+
+            std::vector<rules_t> points;
+            std::vector<nlohmann::json> parameters;
+            for (size_t p = 0; p < spec.points.size(); ++p) {
+                for (double value : values) {
+                    rules_t rules = spec.points[p];
+                    set_rule_field(rules, *field, value);
+                    nlohmann::json point = spec.parameters[p];
+                    point[it.key()] = get_rule_field(rules, *field);
+                    points.push_back(rules);
+                    parameters.push_back(point);
+                }
+            }
+            spec.points.swap(points);
+            spec.parameters.swap(parameters);
+        }
+    } else if (request_body.contains("latin_hypercube")) {
+        // Amostragem por hipercubo latino: cada intervalo é dividido em n estratos,
+        // e cada estrato de cada parâmetro é usado exatamente uma vez
+        const nlohmann::json &lhs = request_body["latin_hypercube"];
+        const uint32_t samples = lhs.value("samples", 0u);
+        const nlohmann::json ranges = lhs.value("ranges", nlohmann::json::object());
+        if (samples == 0 || (size_t)samples * spec.replicates > MAXIMUM_SWEEP_RUNS || !ranges.is_object()) {
+            throw std::invalid_argument("latin_hypercube requer samples e ranges válidos");
+        }
+
+        std::mt19937 gen(static_cast<std::mt19937::result_type>(spec.seed));
+        std::uniform_real_distribution<double> jitter(0.0, 1.0);
+        spec.points.assign(samples, base);
+        spec.parameters.assign(samples, nlohmann::json::object());
+        for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+            const rule_field_t *field = find_rule_field(it.key());
+            if (!field) {
+                throw std::invalid_argument("Regra desconhecida: " + it.key());
+            }
+            std::vector<double> range = sweep_values(it.key(), it.value());
+            if (range.size() != 2 || range[1] < range[0]) {
+                throw std::invalid_argument("O intervalo do parâmetro " + it.key() + " deve ser [mínimo, máximo]");
+            }
+
+            std::vector<uint32_t> strata(samples);
+            for (uint32_t s = 0; s < samples; ++s) {
+                strata[s] = s;
+            }
+            std::shuffle(strata.begin(), strata.end(), gen);
+            for (uint32_t s = 0; s < samples; ++s) {
+                double value = range[0] + (range[1] - range[0]) * (strata[s] + jitter(gen)) / samples;
+                set_rule_field(spec.points[s], *field, value);
+                spec.parameters[s][it.key()] = get_rule_field(spec.points[s], *field);
+            }
+        }
+    } else {
+        spec.points.push_back(base);
+        spec.parameters.push_back(nlohmann::json::object());
+    }
+
+    for (const rules_t &rules : spec.points) {
+        validate_rules(rules);
+    }
+    return spec;
+}
+
+// Função para converter uma contagem de população em um objeto JSON
+inline nlohmann::json populationToJson(const population_t &population) {
+    return {
+        { "plants", population.plants },
+        { "herbivores", population.herbivores },
+        { "carnivores", population.carnivores }
+    };
+}
+
+// Função para executar uma simulação sem interface até a extinção, o estado estacionário ou o limite de iterações
+inline nlohmann::json run_sweep_simulation(const sweep_spec_t &spec, const rules_t &rules, uint64_t seed, const std::atomic<bool> &cancelled) {
+    std::seed_seq seq{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) };
+    std::mt19937 gen(seq);
+    grid_t grid(NUM_ROWS, NUM_ROWS);
+    populate_grid(grid, gen, rules, spec.plants, spec.herbivores, spec.carnivores);
+
+    population_t population = count_population(grid);
+    const population_t initial = population;
+    population_t peak = population;
+    double sum_plants = population.plants, sum_herbivores = population.herbivores, sum_carnivores = population.carnivores;
+
+    std::string stop = "max_iterations";
+    uint64_t iteration = 0;
+    uint32_t unchanged = 0;
+    while (iteration < spec.max_iterations) {
+        if (cancelled) {
+            stop = "cancelled";
+            break;
+        }
+
+        population_t current = population;
+        simulate_iteration(grid, gen, rules, &current);
+        ++iteration;
+
+        peak.plants = std::max(peak.plants, current.plants);
+        peak.herbivores = std::max(peak.herbivores, current.herbivores);
+        peak.carnivores = std::max(peak.carnivores, current.carnivores);
+        sum_plants += current.plants;
+        sum_herbivores += current.herbivores;
+        sum_carnivores += current.carnivores;
+
+        bool same = current.plants == population.plants && current.herbivores == population.herbivores && current.carnivores == population.carnivores;
+        unchanged = same ? unchanged + 1 : 0;
+        population = current;
+
+        // Parar quando uma espécie presente no início desaparece
+        if ((initial.plants > 0 && current.plants == 0) || (initial.herbivores > 0 && current.herbivores == 0) || (initial.carnivores > 0 && current.carnivores == 0)) {
+            stop = "extinction";
+            break;
+        }
+
+        // Parar quando a população não muda durante a janela configurada
+        if (spec.steady_window > 0 && unchanged >= spec.steady_window) {
+            stop = "steady_state";
+            break;
+        }
+    }
+
+    const double samples = static_cast<double>(iteration + 1);
+    return {
+        { "seed", seed },
+        { "iterations", iteration },
+        { "stop", stop },
+        { "final", populationToJson(population) },
+        { "peak", populationToJson(peak) },
+        { "mean", { { "plants", sum_plants / samples }, { "herbivores", sum_herbivores / samples }, { "carnivores", sum_carnivores / samples } } }
+    };
+}
+
+// Defina o serviço de varreduras: registro de jobs e threads de execução em todos os núcleos
+class sweep_service_t {
+public:
+    // Criar um job e enfileirar uma tarefa por execução (ponto x réplica); retorna nullptr
+    // se já há varreduras ativas demais
+    std::shared_ptr<sweep_job_t> submit(const sweep_spec_t &spec) {
+        auto shared_spec = std::make_shared<const sweep_spec_t>(spec);
+        auto job = std::make_shared<sweep_job_t>();
+        job->total = spec.points.size() * spec.replicates;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (active_jobs() >= MAXIMUM_ACTIVE_SWEEPS) {
+                return nullptr;
+            }
+            job->id = next_id_++;
+            jobs_[job->id] = job;
+            forget_old_jobs();
+        }
+
+        for (size_t run = 0; run < job->total; ++run) {
+            pool_.submit([job, shared_spec, run]() {
+                const size_t point = run / shared_spec->replicates;
+                nlohmann::json summary = run_sweep_simulation(*shared_spec, shared_spec->points[point], shared_spec->seed + run, job->cancelled);
+                summary["run"] = run;
+                summary["point"] = point;
+                summary["replicate"] = run % shared_spec->replicates;
+                summary["parameters"] = shared_spec->parameters[point];
+
+                std::lock_guard<std::mutex> lock(job->mutex);
+                job->results.push_back(std::move(summary));
+                job->updated.notify_all();
+            });
+        }
+        return job;
+    }
+
+    std::shared_ptr<sweep_job_t> find(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        return it == jobs_.end() ? nullptr : it->second;
+    }
+
+    // Retornar os resumos a partir de um índice, esperando até wait_ms por novos resultados
+    nlohmann::json poll(sweep_job_t &job, size_t from, uint32_t wait_ms) {
+        std::unique_lock<std::mutex> lock(job.mutex);
+        job.updated.wait_for(lock, std::chrono::milliseconds(wait_ms), [&]() {
+            return job.results.size() > from || job.results.size() == job.total;
+        });
+
+        const size_t completed = job.results.size();
+        nlohmann::json results = nlohmann::json::array();
+        for (size_t i = from; i < completed; ++i) {
+            results.push_back(job.results[i]);
+        }
+
+        std::string status = job.cancelled ? "cancelled" : (completed == job.total ? "done" : "running");
+        return {
+            { "id", job.id },
+            { "status", status },
+            { "completed", completed },
+            { "total", job.total },
+            { "results", results }
+        };
+    }
+
+private:
+    // Contar as varreduras com execuções ainda não terminadas (canceladas incluídas, até
+    // que as execuções em andamento parem)
+    size_t active_jobs() {
+        size_t active = 0;
+        for (auto &entry : jobs_) {
+            std::lock_guard<std::mutex> lock(entry.second->mutex);
+            active += entry.second->results.size() < entry.second->total;
+        }
+        return active;
+    }
+
+    // Descartar os jobs terminados mais antigos acima do limite
+    void forget_old_jobs() {
+        for (auto it = jobs_.begin(); jobs_.size() > MAXIMUM_SWEEP_JOBS && it != jobs_.end();) {
+            std::unique_lock<std::mutex> lock(it->second->mutex);
+            bool finished = it->second->results.size() == it->second->total;
+            lock.unlock();
+            it = finished ? jobs_.erase(it) : std::next(it);
+        }
+    }
+
+    thread_pool_t pool_;
+    std::mutex mutex_;
+    std::map<uint64_t, std::shared_ptr<sweep_job_t>> jobs_;
+    uint64_t next_id_ = 1;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Defina um conjunto fixo de threads que executa tarefas em ordem de chegada
+class thread_pool_t {
+public:
+    explicit thread_pool_t(unsigned num_threads = std::thread::hardware_concurrency()) {
+        if (num_threads == 0) {
+            num_threads = 1;
+        }
+        for (unsigned i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~thread_pool_t() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_all();
+        for (std::thread &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    thread_pool_t(const thread_pool_t &) = delete;
+    thread_pool_t &operator=(const thread_pool_t &) = delete;
+
+    // Enfileirar uma tarefa para ser executada por uma das threads
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        condition_.notify_one();
+    }
+
+    size_t size() const {
+        return workers_.size();
+    }
+
+private:
+    void work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                if (stopping_ && tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopping_ = false;
+};
+
+// Função para obter o conjunto de threads compartilhado pelos laços paralelos de todas as
+// requisições (o processo inteiro usa no máximo um núcleo por thread)
+inline thread_pool_t &parallel_pool() {
+    static thread_pool_t pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+// Função para executar body(0), ..., body(count - 1) distribuídos entre as threads disponíveis.
+// Cada índice é executado exatamente uma vez; a ordem entre índices não é garantida. A
+// thread que chama participa do laço e as demais vêm do conjunto compartilhado: se elas
+// estão ocupadas com outros laços, quem chama faz o trabalho sozinho, sem criar threads.
+// Se body lança uma exceção (em qualquer thread), os índices que faltam são abandonados e,
+// depois que todos os ajudantes saíram do laço, a primeira exceção é relançada a quem chamou.
+inline void parallel_for(size_t count, const std::function<void(size_t)> &body) {
+    struct loop_t {
+        std::atomic<size_t> next{ 0 };
+        size_t count = 0;
+        const std::function<void(size_t)> *body = nullptr;
+        std::mutex mutex;
+        std::condition_variable idle;
+        size_t running = 0;       // ajudantes dentro do laço, protegido pelo mutex
+        std::exception_ptr error; // primeira exceção lançada, protegida pelo mutex
+
+        // Guardar a exceção atual e encerrar o laço
+        void fail() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next = count;
+        }
+    };
+
+    auto loop = std::make_shared<loop_t>();
+    loop->count = count;
+    loop->body = &body;
+    auto work = [](loop_t &loop) {
+        try {
+            for (size_t index = loop.next++; index < loop.count; index = loop.next++) {
+                (*loop.body)(index);
+            }
+        } catch (...) {
+            loop.fail();
+        }
+    };
+
+    // Um ajudante que começa depois do fim do laço não encontra índices e não toca em body
+    thread_pool_t &pool = parallel_pool();
+    const size_t helpers = std::min<size_t>(count, pool.size() + 1) - (count > 0 ? 1 : 0);
+    try {
+        for (size_t h = 0; h < helpers; ++h) {
+            pool.submit([loop, work]() {
+                {
+                    std::lock_guard<std::mutex> lock(loop->mutex);
+                    if (loop->next >= loop->count) {
+                        return;
+                    }
+                    ++loop->running;
+                }
+                work(*loop);
+                std::lock_guard<std::mutex> lock(loop->mutex);
+                if (--loop->running == 0) {
+                    loop->idle.notify_all();
+                }
+            });
+        }
+    } catch (...) {
+        loop->fail();
+    }
+
+    // body vive na pilha de quem chama: só sair depois que nenhum ajudante o usa mais
+    work(*loop);
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->idle.wait(lock, [&]() { return loop->running == 0; });
+    if (loop->error) {
+        std::rethrow_exception(loop->error);
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "png.h"
+#include "snapshot.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// Renderização da grade em ladrilhos de mapa (/tiles/{z}/{x}/{y}).
+//
+// No zoom 0 um único ladrilho cobre o mundo inteiro. A cada zoom o lado de um pixel
+// cai pela metade, até chegar a uma célula por pixel em tile_native_zoom; os zooms
+// seguintes ampliam as células. Quando um pixel cobre 4 x 4 células ou mais, sua cor
+// vem direto do bloco correspondente da pirâmide de resumos, de modo que renderizar
+// um ladrilho custa proporcional aos seus pixels, e não às células que ele cobre.
+
+// Lado de um ladrilho, em pixels
+static const uint32_t TILE_SIZE = 256;
+
+// Número de zooms além de uma célula por pixel (cada um dobra o lado das células)
+static const uint32_t TILE_MAXIMUM_MAGNIFICATION = 4;
+
+// Linhas de pixels renderizadas por tarefa
+static const uint32_t TILE_BAND_ROWS = 32;
+
+// Cores das espécies, do fundo e da área fora do mundo
+static const uint8_t TILE_EMPTY_COLOR[3] = { 245, 240, 225 };
+static const uint8_t TILE_OUTSIDE_COLOR[3] = { 200, 200, 200 };
+static const uint8_t TILE_SPECIES_COLORS[3][3] = { { 60, 170, 70 }, { 230, 170, 40 }, { 200, 50, 50 } };
+
+// Função para calcular o zoom em que um pixel corresponde a uma célula
+inline uint32_t tile_native_zoom(const grid_t &grid) {
+    uint32_t zoom = 0;
+    while ((static_cast<uint64_t>(TILE_SIZE) << zoom) < std::max(grid.rows, grid.cols)) {
+        ++zoom;
+    }
+    return zoom;
+}
+
+// Função para calcular a cor de um pixel a partir do resumo das células que ele cobre:
+// a mistura das cores das espécies, ponderada pela fração de células de cada uma
+inline void tile_color(const block_summary_t &block, uint32_t cells, uint8_t *pixel) {
+    const uint32_t counts[3] = { block.plants, block.herbivores, block.carnivores };
+    for (int channel = 0; channel < 3; ++channel) {
+        uint32_t value = TILE_EMPTY_COLOR[channel] * (cells - block.occupied());
+        for (int species = 0; species < 3; ++species) {
+            value += TILE_SPECIES_COLORS[species][channel] * counts[species];
+        }
+        pixel[channel] = static_cast<uint8_t>(value / cells);
+    }
+}
+
+// Função para renderizar o ladrilho (z, x, y) da publicação como uma imagem RGB
+inline std::vector<uint8_t> render_tile(const world_snapshot_t &snapshot, uint32_t z, uint32_t x, uint32_t y) {
+    const grid_t &grid = snapshot.grid;
+    const uint32_t native = tile_native_zoom(grid);
+    if (z > native + TILE_MAXIMUM_MAGNIFICATION || x >= (1u << z) || y >= (1u << z)) {
+        throw std::invalid_argument("Ladrilho fora do mundo");
+    }
+
+    // Cada pixel cobre 2^shift x 2^shift células (ou, ampliado, 1 / 2^magnify de uma célula)
+    const uint32_t shift = z <= native ? native - z : 0;
+    const uint32_t magnify = z > native ? z - native : 0;
+    const bool from_pyramid = shift >= PYRAMID_BASE_LEVEL;
+    const pyramid_level_t *level = from_pyramid ? &snapshot.pyramid().level(shift) : nullptr;
+    const uint64_t side = 1ull << shift;
+
+    std::vector<uint8_t> rgb(static_cast<size_t>(TILE_SIZE) * TILE_SIZE * 3);
+    parallel_for(TILE_SIZE / TILE_BAND_ROWS, [&](size_t band) {
+        for (uint32_t py = band * TILE_BAND_ROWS; py < (band + 1) * TILE_BAND_ROWS; ++py) {
+            for (uint32_t px = 0; px < TILE_SIZE; ++px) {
+                uint8_t *pixel = rgb.data() + (static_cast<size_t>(py) * TILE_SIZE + px) * 3;
+                // Coordenadas da primeira célula coberta pelo pixel
+                const uint64_t i = ((static_cast<uint64_t>(y) * TILE_SIZE + py) << shift) >> magnify;
+                const uint64_t j = ((static_cast<uint64_t>(x) * TILE_SIZE + px) << shift) >> magnify;
+                if (i >= grid.rows || j >= grid.cols) {
+                    std::copy(TILE_OUTSIDE_COLOR, TILE_OUTSIDE_COLOR + 3, pixel);
+                    continue;
+                }
+
+                block_summary_t block;
+                uint32_t cells = 0;
+                if (from_pyramid) {
+                    block = level->blocks[(i >> shift) * level->cols + (j >> shift)];
+                    cells = static_cast<uint32_t>(std::min<uint64_t>(side, grid.rows - i) * std::min<uint64_t>(side, grid.cols - j));
+                } else {
+                    for (uint64_t di = 0; di < side && i + di < grid.rows; ++di) {
+                        for (uint64_t dj = 0; dj < side && j + dj < grid.cols; ++dj) {
+                            const entity_t &entity = grid[i + di][j + dj];
+                            block.plants += entity.type == plant;
+                            block.herbivores += entity.type == herbivore;
+                            block.carnivores += entity.type == carnivore;
+                            ++cells;
+                        }
+                    }
+                }
+                tile_color(block, cells, pixel);
+            }
+        }
+    });
+    return rgb;
+}
+
+// Função para renderizar o ladrilho (z, x, y) da publicação como PNG
+inline std::string render_tile_png(const world_snapshot_t &snapshot, uint32_t z, uint32_t x, uint32_t y) {
+    return encode_png(render_tile(snapshot, z, x, y), TILE_SIZE, TILE_SIZE);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdio>
+
+// Verificações simples para os testes: cada falha é mostrada e o teste termina com
+// código diferente de zero (ver CHECK_RESULT)
+
+static int check_failures = 0;
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            std::fprintf(stderr, "%s:%d: falhou: %s\n", __FILE__, __LINE__, #condition); \
+            ++check_failures;                                                             \
+        }                                                                                 \
+    } while (0)
+
+#define CHECK_RESULT() (check_failures == 0 ? 0 : 1)
@@ -0,0 +1,85 @@
+// Testes do registro de alterações: aplicar as células alteradas desde uma versão sobre
+// a grade dessa versão reproduz a grade atual, sem comparar as grades inteiras
+
+#include "check.h"
+#include "delta.h"
+#include <map>
+
+// Função para copiar para replica as células indicadas da grade atual (como faz o cliente)
+static void apply_delta(grid_t &replica, const grid_t &grid, const std::vector<uint32_t> &cells) {
+    for (uint32_t cell : cells) {
+        replica.cells[cell] = grid.cells[cell];
+    }
+}
+
+static bool same_grid(const grid_t &a, const grid_t &b) {
+    for (size_t cell = 0; cell < a.size(); ++cell) {
+        if (a.cells[cell].type != b.cells[cell].type || a.cells[cell].energy != b.cells[cell].energy || a.cells[cell].age != b.cells[cell].age) {
+            return false;
+        }
+    }
+    return a.rows == b.rows && a.cols == b.cols;
+}
+
+// Publicações de uma e de várias iterações; réplicas de cada versão alcançam a atual
+static void test_replay_from_every_version() {
+    rules_t rules;
+    std::mt19937 gen(11);
+    grid_t grid(40, 50);
+    populate_grid(grid, gen, rules, 600, 120, 30);
+
+    change_log_t change_log;
+    uint64_t version = 1;
+    change_log.reset(grid, version);
+    std::map<uint64_t, grid_t> replicas = { { version, grid } };
+
+    for (int publication = 0; publication < 30; ++publication) {
+        changed_cells_t changed;
+        const int iterations = 1 + publication % 3;
+        for (int i = 0; i < iterations; ++i) {
+            simulate_iteration(grid, gen, rules, nullptr, &changed);
+        }
+        CHECK(!changed.overflow);
+        change_log.record(grid, ++version, changed);
+        CHECK(changed.cells.empty());
+        replicas[version] = grid;
+
+        for (auto &replica : replicas) {
+            std::vector<uint32_t> cells;
+            if (change_log.changes_since(replica.first, cells)) {
+                CHECK(std::is_sorted(cells.begin(), cells.end()));
+                grid_t updated = replica.second;
+                apply_delta(updated, grid, cells);
+                CHECK(same_grid(updated, grid));
+            }
+        }
+    }
+
+    std::vector<uint32_t> cells;
+    CHECK(change_log.changes_since(version, cells) && cells.empty());
+    CHECK(change_log.changes_since(version - 1, cells) && !cells.empty());
+}
+
+// Um registro que transbordou obriga a enviar um quadro completo
+static void test_overflow_forces_full_frame() {
+    grid_t grid(4, 4);
+    change_log_t change_log;
+    change_log.reset(grid, 1);
+
+    changed_cells_t changed;
+    for (size_t n = 0; n <= grid.size(); ++n) {
+        mark_change(&changed, n % grid.size(), grid.size());
+    }
+    CHECK(changed.overflow && changed.cells.empty());
+    change_log.record(grid, 2, changed);
+
+    std::vector<uint32_t> cells;
+    CHECK(!change_log.changes_since(1, cells));
+    CHECK(change_log.changes_since(2, cells) && cells.empty());
+}
+
+int main() {
+    test_replay_from_every_version();
+    test_overflow_forces_full_frame();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,77 @@
+// Testes do motor de ensemble: cada mundo do ensemble segue a mesma trajetória que
+// o mesmo mundo simulado sozinho, qualquer que seja o número de lanes
+
+#include "check.h"
+#include "ensemble.h"
+
+// Semente de um ensemble de uma lane que reproduz a lane k (ver ensemble_create)
+static uint64_t lane_seed(uint64_t seed, uint32_t k) {
+    return seed + k * 0x9E3779B97F4A7C15ull;
+}
+
+// Compara a lane k do ensemble com a única lane do mundo escalar
+static bool same_world(const ensemble_t &ensemble, uint32_t k, const ensemble_t &scalar) {
+    const size_t num_cells = static_cast<size_t>(ensemble.rows) * ensemble.cols;
+    for (size_t cell = 0; cell < num_cells; ++cell) {
+        const size_t x = cell * ensemble.lanes + k;
+        if (ensemble.type[x] != scalar.type[cell] || ensemble.energy[x] != scalar.energy[cell] || ensemble.age[x] != scalar.age[cell]) {
+            return false;
+        }
+    }
+    return ensemble.rng[k] == scalar.rng[0];
+}
+
+// Cada lane avança exatamente como um ensemble de uma lane com a semente correspondente
+static void test_lanes_match_scalar_worlds() {
+    const uint32_t K = 9;
+    const uint64_t seed = 12345;
+    rules_t rules;
+
+    ensemble_t ensemble = ensemble_create(NUM_ROWS, NUM_ROWS, K, seed);
+    ensemble_populate(ensemble, rules, 40, 12, 4);
+
+    std::vector<ensemble_t> scalars;
+    for (uint32_t k = 0; k < K; ++k) {
+        scalars.push_back(ensemble_create(NUM_ROWS, NUM_ROWS, 1, lane_seed(seed, k)));
+        ensemble_populate(scalars.back(), rules, 40, 12, 4);
+    }
+
+    for (int step = 0; step <= 60; ++step) {
+        if (step > 0) {
+            ensemble_step(ensemble, rules);
+            for (ensemble_t &scalar : scalars) {
+                ensemble_step(scalar, rules);
+            }
+        }
+        for (uint32_t k = 0; k < K; ++k) {
+            CHECK(same_world(ensemble, k, scalars[k]));
+        }
+    }
+}
+
+// Um mundo que se esvazia não altera a sequência de sorteios dos outros
+static void test_empty_lane_does_not_shift_others() {
+    const uint64_t seed = 777;
+    rules_t rules;
+
+    ensemble_t ensemble = ensemble_create(NUM_ROWS, NUM_ROWS, 2, seed);
+    ensemble_populate(ensemble, rules, 30, 10, 3);
+    for (size_t cell = 0; cell < static_cast<size_t>(NUM_ROWS) * NUM_ROWS; ++cell) {
+        ensemble.type[cell * 2] = empty;
+    }
+
+    ensemble_t scalar = ensemble_create(NUM_ROWS, NUM_ROWS, 1, lane_seed(seed, 1));
+    ensemble_populate(scalar, rules, 30, 10, 3);
+
+    for (int step = 0; step < 60; ++step) {
+        ensemble_step(ensemble, rules);
+        ensemble_step(scalar, rules);
+    }
+    CHECK(same_world(ensemble, 1, scalar));
+}
+
+int main() {
+    test_lanes_match_scalar_worlds();
+    test_empty_lane_does_not_shift_others();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,104 @@
+// Testes do quadro binário: uma grade completa volta intacta de gridToFrame para
+// frameToGrid, com ou sem trechos no plano de tipos, e quadros danificados são recusados
+
+#include "check.h"
+#include "frame.h"
+#include <random>
+
+// Função para comparar duas grades célula a célula
+static bool same_grid(const grid_t &a, const grid_t &b) {
+    if (a.rows != b.rows || a.cols != b.cols) {
+        return false;
+    }
+    for (size_t cell = 0; cell < a.size(); ++cell) {
+        if (a.cells[cell].type != b.cells[cell].type || a.cells[cell].energy != b.cells[cell].energy || a.cells[cell].age != b.cells[cell].age) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Grade aleatória; sparse deixa quase tudo vazio, o que faz o plano de tipos usar trechos
+static grid_t random_grid(std::mt19937 &gen, bool sparse) {
+    grid_t grid(1 + gen() % 60, 1 + gen() % 60);
+    for (size_t cell = 0; cell < grid.size(); ++cell) {
+        if (sparse && gen() % 16 != 0) {
+            continue;
+        }
+        grid.cells[cell] = { static_cast<entity_type>(gen() % 4), static_cast<uint32_t>(gen()), static_cast<uint32_t>(gen() % 1000) };
+    }
+    return grid;
+}
+
+// Ida e volta preserva as células e o cabeçalho
+static void test_round_trip() {
+    std::mt19937 gen(3);
+    bool saw_rle = false, saw_plain = false;
+    for (int round = 0; round < 40; ++round) {
+        const grid_t grid = random_grid(gen, round % 2 == 0);
+        frame_header_t header;
+        header.tick = gen();
+        header.seed = (uint64_t(gen()) << 32) | gen();
+        header.version = round + 1;
+
+        const std::string frame = gridToFrame(grid, header);
+        const bool rle = get_frame_integer(frame, 6, 2) & FRAME_FLAG_RLE_TYPES;
+        saw_rle = saw_rle || rle;
+        saw_plain = saw_plain || !rle;
+
+        grid_t decoded;
+        frame_header_t decoded_header;
+        frameToGrid(frame, decoded, decoded_header);
+        CHECK(same_grid(grid, decoded));
+        CHECK(decoded_header.tick == header.tick && decoded_header.seed == header.seed && decoded_header.version == header.version);
+    }
+    CHECK(saw_rle && saw_plain);
+}
+
+// As colunas de 32 bits começam em posições múltiplas de 4 e o quadro tem o tamanho esperado
+static void test_layout() {
+    grid_t grid(3, 5);
+    grid.cells[7] = { herbivore, 50, 2 };
+    const std::string frame = gridToFrame(grid, frame_header_t());
+    CHECK(FRAME_HEADER_SIZE % 4 == 0);
+    CHECK(frame.size() == FRAME_HEADER_SIZE + grid.size() * 9);
+    CHECK(get_frame_integer(frame, FRAME_HEADER_SIZE + 7 * 4, 4) == 50);
+    CHECK(get_frame_integer(frame, FRAME_HEADER_SIZE + grid.size() * 4 + 7 * 4, 4) == 2);
+}
+
+// Quadros truncados, com outra assinatura ou com tipos inválidos são recusados
+static void test_rejects_damaged_frames() {
+    std::mt19937 gen(5);
+    const grid_t grid = random_grid(gen, false);
+    const std::string frame = gridToFrame(grid, frame_header_t());
+
+    auto rejected = [](const std::string &damaged) {
+        grid_t decoded;
+        frame_header_t header;
+        try {
+            frameToGrid(damaged, decoded, header);
+        } catch (const std::invalid_argument &) {
+            return true;
+        }
+        return false;
+    };
+    CHECK(rejected(frame.substr(0, frame.size() - 1)));
+    CHECK(rejected(frame.substr(0, FRAME_HEADER_SIZE - 1)));
+
+    std::string wrong_magic = frame;
+    wrong_magic[0] = 'X';
+    CHECK(rejected(wrong_magic));
+
+    std::string wrong_type = frame;
+    wrong_type[frame.size() - 1] = 9;
+    CHECK(rejected(wrong_type));
+
+    CHECK(rejected(deltaToFrame(grid, frame_header_t(), { 0 })));
+}
+
+int main() {
+    test_round_trip();
+    test_layout();
+    test_rejects_damaged_frames();
+    return CHECK_RESULT();
+}
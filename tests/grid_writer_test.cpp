@@ -0,0 +1,66 @@
+// Testes da escrita da grade em JSON: o texto é idêntico, byte a byte, ao que
+// nlohmann::json::dump() produz para a mesma grade montada como árvore
+
+#include "check.h"
+#include "grid_writer.h"
+#include "json.hpp"
+#include <random>
+
+// Grade como árvore JSON, como era montada antes do escritor direto
+static nlohmann::json grid_dom(const grid_t &grid, const projection_t &projection) {
+    nlohmann::json json_grid = nlohmann::json::array();
+    for (uint32_t i = 0; i < grid.rows; ++i) {
+        nlohmann::json json_row = nlohmann::json::array();
+        for (uint32_t j = 0; j < grid.cols; ++j) {
+            const entity_t &entity = grid[i][j];
+            nlohmann::json json_entity = nlohmann::json::object();
+            if (projection.fields & type_field) {
+                json_entity["type"] = entity.type;
+            }
+            if (projection.fields & energy_field) {
+                json_entity["energy"] = quantize(entity.energy, projection.bucket);
+            }
+            if (projection.fields & age_field) {
+                json_entity["age"] = quantize(entity.age, projection.bucket);
+            }
+            json_row.push_back(json_entity);
+        }
+        json_grid.push_back(json_row);
+    }
+    return json_grid;
+}
+
+// Grade aleatória, com energias e idades de todas as ordens de grandeza
+static grid_t random_grid(std::mt19937 &gen) {
+    grid_t grid(1 + gen() % 40, 1 + gen() % 40);
+    for (uint32_t c = 0; c < grid.size(); ++c) {
+        entity_t &entity = grid.cells[c];
+        entity.type = static_cast<entity_type>(gen() % 4);
+        entity.energy = gen() >> (gen() % 32);
+        entity.age = gen() % 3 ? gen() % 200 : gen();
+    }
+    return grid;
+}
+
+// Grade completa e todas as combinações de campos, com e sem quantização
+static void test_matches_dom_dump() {
+    std::mt19937 gen(1);
+    for (int round = 0; round < 30; ++round) {
+        const grid_t grid = random_grid(gen);
+        CHECK(gridToJsonString(grid) == grid_dom(grid, projection_t()).dump());
+
+        for (unsigned fields = 1; fields <= all_fields; ++fields) {
+            for (uint32_t bucket : { 1u, 10u }) {
+                projection_t projection;
+                projection.fields = fields;
+                projection.bucket = bucket;
+                CHECK(gridToJsonString(grid, projection) == grid_dom(grid, projection).dump());
+            }
+        }
+    }
+}
+
+int main() {
+    test_matches_dom_dump();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,51 @@
+// Testes do pacer: leitura do orçamento de quadro (?budget= e "budget" no WebSocket) e
+// número de iterações escolhido
+
+#include "check.h"
+#include "pacing.h"
+#include <cmath>
+#include <limits>
+
+// Textos que não são um número finito completo são recusados
+static void test_parse_frame_budget() {
+    double milliseconds = 0;
+    CHECK(parse_frame_budget("16", milliseconds) && milliseconds == 16);
+    CHECK(parse_frame_budget("2.5", milliseconds) && milliseconds == 2.5);
+    CHECK(parse_frame_budget("-3", milliseconds) && milliseconds == -3);
+
+    CHECK(!parse_frame_budget("nan", milliseconds));
+    CHECK(!parse_frame_budget("NaN", milliseconds));
+    CHECK(!parse_frame_budget("inf", milliseconds));
+    CHECK(!parse_frame_budget("-infinity", milliseconds));
+    CHECK(!parse_frame_budget("1e999", milliseconds));
+    CHECK(!parse_frame_budget("", milliseconds));
+    CHECK(!parse_frame_budget("16ms", milliseconds));
+    CHECK(!parse_frame_budget("16 ", milliseconds));
+    CHECK(!parse_frame_budget("abc", milliseconds));
+}
+
+// O orçamento fica nos limites aceitos, NaN é ignorado e o número de iterações é sempre válido
+static void test_set_budget() {
+    frame_pacer_t pacer;
+    pacer.set_budget(std::numeric_limits<double>::quiet_NaN());
+    CHECK(pacer.budget_ms() == PACER_DEFAULT_BUDGET_MS);
+
+    pacer.set_budget(-5);
+    CHECK(pacer.budget_ms() == PACER_MINIMUM_BUDGET_MS);
+    pacer.set_budget(std::numeric_limits<double>::infinity());
+    CHECK(pacer.budget_ms() == PACER_MAXIMUM_BUDGET_MS);
+
+    pacer.set_budget(16);
+    CHECK(pacer.iterations() == 1);
+    pacer.measure(10, 0.01);
+    CHECK(pacer.iterations() == 16);
+    CHECK(!pacer.slice_iterations());
+    pacer.set_budget(std::numeric_limits<double>::quiet_NaN());
+    CHECK(pacer.iterations() == 16);
+}
+
+int main() {
+    test_parse_frame_budget();
+    test_set_budget();
+    return CHECK_RESULT();
+}
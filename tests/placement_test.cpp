@@ -0,0 +1,63 @@
+// Testes do sorteador de células: os sorteios nunca se repetem, cobrem a grade quando
+// a esgotam e são recusados quando não há mais células livres
+
+#include "check.h"
+#include "placement.h"
+#include <stdexcept>
+
+// Sorteia draws células de uma grade de num_cells e verifica que são distintas e válidas
+static void check_distinct(uint64_t num_cells, uint64_t draws, uint64_t expected_draws) {
+    std::mt19937 gen(42);
+    cell_sampler_t sampler(num_cells, expected_draws);
+    std::vector<bool> seen(num_cells, false);
+    bool distinct = true;
+    for (uint64_t n = 0; n < draws; ++n) {
+        const uint64_t cell = sampler.next(gen);
+        distinct = distinct && cell < num_cells && !seen[cell];
+        if (cell < num_cells) {
+            seen[cell] = true;
+        }
+    }
+    CHECK(distinct);
+    CHECK(sampler.remaining() == num_cells - draws);
+}
+
+// Caminho esparso (tabela hash, inclusive crescendo além da estimativa) e denso
+static void test_distinct_cells() {
+    check_distinct(1000000, 5000, 5000);
+    check_distinct(1000000, 5000, 100);
+    check_distinct(1000, 1000, 1000);
+    check_distinct(4096, 4096, 10);
+}
+
+// Esgotada a grade, um novo sorteio é recusado em vez de sair dos limites
+static void test_exhausted_sampler() {
+    std::mt19937 gen(7);
+    cell_sampler_t dense(16, 16);
+    cell_sampler_t sparse(1 << 20, 1);
+    for (int n = 0; n < 16; ++n) {
+        dense.next(gen);
+    }
+
+    bool dense_refused = false;
+    try {
+        dense.next(gen);
+    } catch (const std::out_of_range &) {
+        dense_refused = true;
+    }
+    CHECK(dense_refused);
+
+    bool offset_refused = false;
+    try {
+        sparse.select(1 << 20);
+    } catch (const std::out_of_range &) {
+        offset_refused = true;
+    }
+    CHECK(offset_refused);
+}
+
+int main() {
+    test_distinct_cells();
+    test_exhausted_sampler();
+    return CHECK_RESULT();
+}
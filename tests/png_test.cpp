@@ -0,0 +1,253 @@
+// Testes do codificador PNG: um decodificador independente (inflate e desfiltragem das
+// linhas) recupera exatamente os pixels codificados, e os CRCs e o Adler-32 conferem
+
+#include "check.h"
+#include "png.h"
+#include <random>
+#include <stdexcept>
+
+// Leitura de bits na ordem do deflate (bit menos significativo primeiro)
+struct bit_reader_t {
+    const std::string &data;
+    size_t position;
+    uint32_t buffer = 0;
+    int count = 0;
+
+    uint32_t bits(int needed) {
+        while (count < needed) {
+            if (position >= data.size()) {
+                throw std::runtime_error("deflate truncado");
+            }
+            buffer |= static_cast<uint32_t>(static_cast<uint8_t>(data[position++])) << count;
+            count += 8;
+        }
+        const uint32_t value = buffer & ((1u << needed) - 1);
+        buffer >>= needed;
+        count -= needed;
+        return value;
+    }
+};
+
+// Código de Huffman canônico a partir dos comprimentos de cada símbolo
+struct huffman_t {
+    std::vector<int> counts = std::vector<int>(16, 0);
+    std::vector<int> symbols;
+
+    explicit huffman_t(const std::vector<int> &lengths) {
+        std::vector<int> offsets(16, 0);
+        for (int length : lengths) {
+            ++counts[length];
+        }
+        counts[0] = 0;
+        for (int length = 1; length < 16; ++length) {
+            offsets[length] = offsets[length - 1] + counts[length - 1];
+        }
+        symbols.resize(lengths.size());
+        for (size_t symbol = 0; symbol < lengths.size(); ++symbol) {
+            if (lengths[symbol] > 0) {
+                symbols[offsets[lengths[symbol]]++] = static_cast<int>(symbol);
+            }
+        }
+    }
+
+    int decode(bit_reader_t &reader) const {
+        int code = 0, first = 0, index = 0;
+        for (int length = 1; length < 16; ++length) {
+            code |= static_cast<int>(reader.bits(1));
+            if (code - first < counts[length]) {
+                return symbols[index + code - first];
+            }
+            index += counts[length];
+            first = (first + counts[length]) << 1;
+            code <<= 1;
+        }
+        throw std::runtime_error("código de Huffman inválido");
+    }
+};
+
+// Função para descomprimir um fluxo zlib com blocos sem compressão ou com Huffman fixo
+static std::vector<uint8_t> zlib_decompress(const std::string &stream) {
+    static const int length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const int length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const int distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const int distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    if (stream.size() < 6 || (static_cast<uint8_t>(stream[0]) & 0x0F) != 8 || ((static_cast<uint8_t>(stream[0]) << 8) | static_cast<uint8_t>(stream[1])) % 31 != 0) {
+        throw std::runtime_error("cabeçalho zlib inválido");
+    }
+
+    std::vector<int> fixed_lengths(288, 8);
+    std::fill(fixed_lengths.begin() + 144, fixed_lengths.begin() + 256, 9);
+    std::fill(fixed_lengths.begin() + 256, fixed_lengths.begin() + 280, 7);
+    const huffman_t fixed_literals(fixed_lengths);
+    const huffman_t fixed_distances(std::vector<int>(30, 5));
+
+    std::vector<uint8_t> out;
+    bit_reader_t reader{ stream, 2 };
+    bool last = false;
+    while (!last) {
+        last = reader.bits(1);
+        const uint32_t type = reader.bits(2);
+        if (type == 0) {
+            reader.buffer = 0;
+            reader.count = 0;
+            const uint32_t length = reader.bits(16);
+            reader.bits(16);
+            for (uint32_t k = 0; k < length; ++k) {
+                out.push_back(static_cast<uint8_t>(reader.bits(8)));
+            }
+            continue;
+        }
+        if (type != 1) {
+            throw std::runtime_error("tipo de bloco não suportado pelo teste");
+        }
+        for (;;) {
+            const int symbol = fixed_literals.decode(reader);
+            if (symbol < 256) {
+                out.push_back(static_cast<uint8_t>(symbol));
+                continue;
+            }
+            if (symbol == 256) {
+                break;
+            }
+            const int length = length_base[symbol - 257] + static_cast<int>(reader.bits(length_extra[symbol - 257]));
+            const int code = fixed_distances.decode(reader);
+            const size_t distance = distance_base[code] + reader.bits(distance_extra[code]);
+            if (distance > out.size()) {
+                throw std::runtime_error("distância inválida");
+            }
+            for (int k = 0; k < length; ++k) {
+                out.push_back(out[out.size() - distance]);
+            }
+        }
+    }
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : out) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    const size_t tail = reader.position;
+    uint32_t adler = 0;
+    for (size_t k = 0; k < 4; ++k) {
+        adler = (adler << 8) | static_cast<uint8_t>(stream.at(tail + k));
+    }
+    if (adler != ((b << 16) | a)) {
+        throw std::runtime_error("Adler-32 não confere");
+    }
+    return out;
+}
+
+static uint32_t read_u32(const std::string &png, size_t offset) {
+    uint32_t value = 0;
+    for (size_t k = 0; k < 4; ++k) {
+        value = (value << 8) | static_cast<uint8_t>(png.at(offset + k));
+    }
+    return value;
+}
+
+// Função para decodificar um PNG RGB de 8 bits, conferindo o CRC de cada bloco
+static std::vector<uint8_t> decode_png(const std::string &png, uint32_t &width, uint32_t &height) {
+    if (png.compare(0, 8, std::string("\x89PNG\r\n\x1a\n", 8)) != 0) {
+        throw std::runtime_error("assinatura PNG inválida");
+    }
+    std::string idat;
+    bool ended = false;
+    for (size_t offset = 8; !ended;) {
+        const uint32_t length = read_u32(png, offset);
+        const std::string type = png.substr(offset + 4, 4);
+        const std::string data = png.substr(offset + 8, length);
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t k = offset + 4; k < offset + 8 + length; ++k) {
+            crc = png_crc_table()[(crc ^ static_cast<uint8_t>(png[k])) & 0xFF] ^ (crc >> 8);
+        }
+        if ((crc ^ 0xFFFFFFFFu) != read_u32(png, offset + 8 + length)) {
+            throw std::runtime_error("CRC do bloco " + type + " não confere");
+        }
+
+        if (type == "IHDR") {
+            width = read_u32(data, 0);
+            height = read_u32(data, 4);
+            if (data.substr(8) != std::string("\x08\x02\x00\x00\x00", 5)) {
+                throw std::runtime_error("formato de pixel inesperado");
+            }
+        } else if (type == "IDAT") {
+            idat += data;
+        } else if (type == "IEND") {
+            ended = true;
+        }
+        offset += 12 + length;
+    }
+
+    const std::vector<uint8_t> filtered = zlib_decompress(idat);
+    const size_t stride = static_cast<size_t>(width) * 3;
+    if (filtered.size() != (stride + 1) * height) {
+        throw std::runtime_error("tamanho dos dados inválido");
+    }
+    std::vector<uint8_t> rgb(stride * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t filter = filtered[y * (stride + 1)];
+        const uint8_t *line = &filtered[y * (stride + 1) + 1];
+        uint8_t *row = &rgb[y * stride];
+        for (size_t k = 0; k < stride; ++k) {
+            const int left = k >= 3 ? row[k - 3] : 0;
+            const int up = y > 0 ? row[k - stride] : 0;
+            const int up_left = y > 0 && k >= 3 ? row[k - stride - 3] : 0;
+            int predictor = 0;
+            if (filter == 1) {
+                predictor = left;
+            } else if (filter == 2) {
+                predictor = up;
+            } else if (filter == 3) {
+                predictor = (left + up) / 2;
+            } else if (filter == 4) {
+                const int p = left + up - up_left, pa = std::abs(p - left), pb = std::abs(p - up), pc = std::abs(p - up_left);
+                predictor = pa <= pb && pa <= pc ? left : pb <= pc ? up : up_left;
+            } else if (filter != 0) {
+                throw std::runtime_error("filtro inválido");
+            }
+            row[k] = static_cast<uint8_t>(line[k] + predictor);
+        }
+    }
+    return rgb;
+}
+
+// Codificar e decodificar uma imagem, conferindo dimensões e pixels
+static void check_round_trip(const std::vector<uint8_t> &rgb, uint32_t width, uint32_t height) {
+    uint32_t decoded_width = 0, decoded_height = 0;
+    std::vector<uint8_t> decoded;
+    try {
+        decoded = decode_png(encode_png(rgb, width, height), decoded_width, decoded_height);
+    } catch (const std::exception &error) {
+        std::fprintf(stderr, "%ux%u: %s\n", width, height, error.what());
+    }
+    CHECK(decoded_width == width && decoded_height == height);
+    CHECK(decoded == rgb);
+}
+
+// Ruído (literais), cor única (repetições longas), faixas e gradientes (filtros Sub e Up)
+static void test_round_trip() {
+    std::mt19937 gen(13);
+    for (auto dims : { std::make_pair(256u, 256u), std::make_pair(1u, 1u), std::make_pair(1u, 300u), std::make_pair(300u, 1u), std::make_pair(37u, 53u) }) {
+        const uint32_t width = dims.first, height = dims.second;
+        const size_t size = static_cast<size_t>(width) * height * 3;
+
+        std::vector<uint8_t> noise(size), flat(size, 200), stripes(size), gradient(size);
+        for (size_t k = 0; k < size; ++k) {
+            noise[k] = static_cast<uint8_t>(gen());
+            const size_t pixel = k / 3, x = pixel % width, y = pixel / width;
+            stripes[k] = (y / 4) % 2 ? 255 : 0;
+            gradient[k] = static_cast<uint8_t>(x + 2 * y + k % 3);
+        }
+        check_round_trip(noise, width, height);
+        check_round_trip(flat, width, height);
+        check_round_trip(stripes, width, height);
+        check_round_trip(gradient, width, height);
+    }
+}
+
+int main() {
+    test_round_trip();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,76 @@
+// Testes da pirâmide de resumos: a atualização incremental (update_pyramid e
+// follow_pyramid) chega aos mesmos blocos que montar a pirâmide de novo
+
+#include "check.h"
+#include "snapshot.h"
+
+// Função para comparar duas pirâmides bloco a bloco
+static bool same_pyramid(const pyramid_t &a, const pyramid_t &b) {
+    if (a.levels.size() != b.levels.size()) {
+        return false;
+    }
+    for (size_t l = 0; l < a.levels.size(); ++l) {
+        const pyramid_level_t &x = a.levels[l], &y = b.levels[l];
+        if (x.level != y.level || x.rows != y.rows || x.cols != y.cols || x.blocks.size() != y.blocks.size()) {
+            return false;
+        }
+        for (size_t k = 0; k < x.blocks.size(); ++k) {
+            const block_summary_t &p = x.blocks[k], &q = y.blocks[k];
+            if (p.plants != q.plants || p.herbivores != q.herbivores || p.carnivores != q.carnivores || p.energy != q.energy) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Alterações aleatórias em grades de lados que não são potências de 2 (blocos parciais na borda)
+static void test_update_matches_build() {
+    std::mt19937 gen(9);
+    for (auto dims : { std::make_pair(301u, 517u), std::make_pair(64u, 64u), std::make_pair(5u, 3u), std::make_pair(1u, 1000u) }) {
+        grid_t grid(dims.first, dims.second);
+        pyramid_t pyramid = build_pyramid(grid);
+        for (int round = 0; round < 20; ++round) {
+            std::vector<uint32_t> cells;
+            const size_t changes = 1 + gen() % 50;
+            for (size_t n = 0; n < changes; ++n) {
+                const uint32_t cell = gen() % grid.size();
+                grid.cells[cell] = { static_cast<entity_type>(gen() % 4), gen() % 200, 0 };
+                cells.push_back(cell);
+            }
+            update_pyramid(pyramid, grid, cells);
+            CHECK(same_pyramid(pyramid, build_pyramid(grid)));
+        }
+    }
+}
+
+// Publicações seguidas de uma simulação, com a pirâmide derivada da publicação anterior
+static void test_follow_matches_build() {
+    rules_t rules;
+    std::mt19937 gen(5);
+    grid_t grid(301, 517);
+    populate_grid(grid, gen, rules, grid.size() / 5, grid.size() / 20, grid.size() / 80);
+
+    change_log_t change_log;
+    frame_header_t header;
+    header.version = 1;
+    change_log.reset(grid, header.version);
+    auto previous = std::make_shared<world_snapshot_t>(grid, header);
+    previous->pyramid();
+
+    for (int tick = 0; tick < 20; ++tick) {
+        changed_cells_t changed;
+        simulate_iteration(grid, gen, rules, nullptr, &changed);
+        change_log.record(grid, ++header.version, changed);
+        auto next = std::make_shared<world_snapshot_t>(grid, header);
+        next->follow_pyramid(previous.get(), change_log);
+        CHECK(same_pyramid(next->pyramid(), build_pyramid(grid)));
+        previous = next;
+    }
+}
+
+int main() {
+    test_update_matches_build();
+    test_follow_matches_build();
+    return CHECK_RESULT();
+}
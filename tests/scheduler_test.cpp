@@ -0,0 +1,141 @@
+// Testes do escalonador de CPU: divisão do tempo por peso e relógio virtual monotônico,
+// misturando concessões com espera (acquire) e oportunistas (try_acquire). O escalonador
+// usa relógios controlados pelo teste, então os resultados não dependem da máquina.
+
+#include "check.h"
+#include "scheduler.h"
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+// Relógios controlados: o tempo de CPU é de cada thread e o de parede é compartilhado;
+// ambos só andam quando o teste chama work
+static thread_local uint64_t fake_cpu_ns = 0;
+static std::atomic<uint64_t> fake_wall_ns{ 0 };
+
+static uint64_t fake_cpu_clock() {
+    return fake_cpu_ns;
+}
+
+static uint64_t fake_wall_clock() {
+    return fake_wall_ns;
+}
+
+static const scheduler_clock_t FAKE_CLOCK{ fake_cpu_clock, fake_wall_clock };
+
+// Simular milliseconds de CPU na thread atual
+static void work(double milliseconds) {
+    const uint64_t nanoseconds = static_cast<uint64_t>(milliseconds * 1e6);
+    fake_cpu_ns += nanoseconds;
+    fake_wall_ns += nanoseconds;
+}
+
+// Esperar até que count pedidos estejam na fila do escalonador (ou stop)
+static void wait_for_waiting(cpu_scheduler_t &scheduler, size_t count, const std::atomic<bool> &stop) {
+    while (scheduler.waiting() < count && !stop) {
+        std::this_thread::yield();
+    }
+}
+
+// Uma conta que volta depois de ociosa por try_acquire não recebe crédito: seu tempo
+// virtual começa no da última concessão, e o relógio não volta
+static void test_try_acquire_catches_up() {
+    cpu_scheduler_t scheduler(1, FAKE_CLOCK);
+    cpu_account_t busy, idle;
+    for (int round = 0; round < 3; ++round) {
+        cpu_grant_t grant = scheduler.acquire(busy, batch_priority);
+        work(5);
+    }
+    const double busy_time = busy.virtual_time;
+    CHECK(busy.batch_ns == 15000000);
+
+    double clock = 0;
+    {
+        cpu_grant_t grant = scheduler.try_acquire(idle, batch_priority);
+        CHECK(static_cast<bool>(grant));
+        CHECK(idle.virtual_time > 0);
+        CHECK(idle.virtual_time <= busy_time);
+        clock = idle.virtual_time;
+    }
+
+    // Uma conta ainda mais atrasada depois dela também parte do relógio, que não voltou
+    cpu_account_t late;
+    cpu_grant_t grant = scheduler.try_acquire(late, interactive_priority);
+    CHECK(static_cast<bool>(grant));
+    CHECK(late.virtual_time >= clock);
+
+    // Com o slot ocupado, a concessão oportunista é recusada
+    cpu_account_t other;
+    CHECK(!scheduler.try_acquire(other, batch_priority));
+}
+
+// Duas contas disputam um slot por total_slices fatias de 2 ms. Como o trabalho longo do
+// motor, cada concessão roda até 100 fatias, cedendo a vez com yield entre elas, e a conta
+// pesada tenta primeiro a concessão oportunista. Antes de cada fatia, quem tem o slot
+// espera a outra conta entrar na fila, de modo que toda decisão do escalonador vê as duas.
+// Retorna a razão entre o tempo de CPU da conta pesada e o da leve.
+static double run_weighted_share(double heavy_weight, int total_slices, uint64_t *light_ns, uint64_t *heavy_ns) {
+    cpu_scheduler_t scheduler(1, FAKE_CLOCK);
+    cpu_account_t light, heavy, starter;
+    light.weight = 1;
+    heavy.weight = heavy_weight;
+    std::atomic<bool> stop{ false };
+    std::atomic<int> slices{ 0 };
+
+    auto run = [&](cpu_account_t &account, bool opportunistic) {
+        fake_cpu_ns = 0;
+        while (!stop) {
+            cpu_grant_t grant = opportunistic ? scheduler.try_acquire(account, batch_priority) : cpu_grant_t();
+            if (!grant) {
+                grant = scheduler.acquire(account, batch_priority);
+            }
+            for (int slice = 0; slice < 100 && !stop; ++slice) {
+                wait_for_waiting(scheduler, 1, stop);
+                if (++slices >= total_slices) {
+                    stop = true;
+                }
+                work(2);
+                grant.yield();
+            }
+        }
+    };
+
+    // O slot fica ocupado até as duas contas estarem na fila, a leve primeiro
+    std::thread light_thread, heavy_thread;
+    {
+        cpu_grant_t grant = scheduler.acquire(starter, batch_priority);
+        light_thread = std::thread(run, std::ref(light), false);
+        wait_for_waiting(scheduler, 1, stop);
+        heavy_thread = std::thread(run, std::ref(heavy), true);
+        wait_for_waiting(scheduler, 2, stop);
+    }
+    light_thread.join();
+    heavy_thread.join();
+
+    *light_ns = light.batch_ns;
+    *heavy_ns = heavy.batch_ns;
+    return double(heavy.batch_ns) / double(light.batch_ns);
+}
+
+// Com um slot disputado, o tempo de CPU se divide na proporção dos pesos, e o resultado é
+// o mesmo em toda execução
+static void test_weighted_share_with_try_acquire() {
+    uint64_t light_ns, heavy_ns;
+    const double ratio = run_weighted_share(3, 2000, &light_ns, &heavy_ns);
+    std::printf("cpu heavy/light = %.2f\n", ratio);
+    CHECK(ratio > 2.7 && ratio < 3.3);
+    CHECK(light_ns + heavy_ns == 2000 * 2000000ull);
+
+    uint64_t again_light_ns, again_heavy_ns;
+    run_weighted_share(3, 2000, &again_light_ns, &again_heavy_ns);
+    CHECK(again_light_ns == light_ns && again_heavy_ns == heavy_ns);
+
+    // Pesos iguais dividem o tempo ao meio
+    CHECK(std::abs(run_weighted_share(1, 2000, &light_ns, &heavy_ns) - 1.0) < 0.1);
+}
+
+int main() {
+    test_try_acquire_catches_up();
+    test_weighted_share_with_try_acquire();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,69 @@
+// Testes do registro de sessões: o limite de sessões abertas não consome identificadores e
+// o despejo por memória poupa a sessão usada por último e as usadas há pouco
+
+#include "check.h"
+#include "session.h"
+
+// Colocar uma grade preenchida na sessão e publicá-la
+static void fill(const std::shared_ptr<session_t> &session, uint32_t rows, uint32_t cols) {
+    std::lock_guard<std::mutex> lock(session->mutex);
+    session->grid = grid_t(rows, cols);
+    session->restart(population_t(), nullptr);
+}
+
+// Com o limite atingido, create() falha sem gastar um identificador
+static void test_cap_does_not_consume_ids() {
+    session_registry_t registry;
+    registry.configure(SIZE_MAX, (std::filesystem::temp_directory_path() / "ecosim-session-test").string(), 2);
+    std::shared_ptr<session_t> first = registry.create();
+    std::shared_ptr<session_t> second = registry.create();
+    CHECK(first && first->id == 1);
+    CHECK(second && second->id == 2);
+    CHECK(registry.create() == nullptr);
+    CHECK(registry.create() == nullptr);
+    CHECK(registry.remove(first->id));
+    std::shared_ptr<session_t> third = registry.create();
+    CHECK(third && third->id == 3);
+}
+
+// Acima do orçamento, as sessões ociosas são despejadas da mais antiga para a mais nova,
+// mas a usada por último e as usadas há menos de SESSION_EVICTION_MINIMUM_IDLE_MS ficam
+static void test_eviction_spares_recent_sessions() {
+    const std::string directory = (std::filesystem::temp_directory_path() / "ecosim-session-test").string();
+    session_registry_t registry;
+    registry.configure(SIZE_MAX, directory, 8);
+    std::vector<std::shared_ptr<session_t>> sessions;
+    for (int i = 0; i < 4; ++i) {
+        sessions.push_back(registry.create());
+        fill(sessions.back(), 64, 64);
+    }
+    const int64_t now = session_clock_ms();
+    sessions[0]->last_access = now - 30000;
+    sessions[1]->last_access = now - 20000;
+    sessions[2]->last_access = now - 100; // usada há pouco: ainda não está ociosa
+    sessions[3]->last_access = now;
+
+    registry.configure(1, directory, 8);
+    registry.enforce_budget();
+    CHECK(!sessions[0]->spill_path.empty());
+    CHECK(!sessions[1]->spill_path.empty());
+    CHECK(sessions[2]->spill_path.empty());
+    CHECK(sessions[3]->spill_path.empty());
+
+    // Mesmo ociosa, a sessão usada por último continua em memória
+    sessions[2]->last_access = now - 6000;
+    sessions[3]->last_access = now - 5000;
+    registry.enforce_budget();
+    CHECK(!sessions[2]->spill_path.empty());
+    CHECK(sessions[3]->spill_path.empty());
+
+    for (const std::shared_ptr<session_t> &session : sessions) {
+        std::remove(session->spill_path.c_str());
+    }
+}
+
+int main() {
+    test_cap_does_not_consume_ids();
+    test_eviction_spares_recent_sessions();
+    return CHECK_RESULT();
+}
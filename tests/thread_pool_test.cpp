@@ -0,0 +1,63 @@
+// Testes do laço paralelo: cada índice roda uma vez, e uma exceção lançada em qualquer
+// thread chega a quem chamou só depois que os ajudantes saíram do laço
+
+#include "check.h"
+#include "thread_pool.h"
+#include <stdexcept>
+
+// Todos os índices são executados exatamente uma vez
+static void test_every_index_once() {
+    std::vector<std::atomic<int>> hits(10000);
+    parallel_for(hits.size(), [&](size_t index) { ++hits[index]; });
+    bool once = true;
+    for (const std::atomic<int> &hit : hits) {
+        once = once && hit == 1;
+    }
+    CHECK(once);
+}
+
+// A exceção é relançada a quem chamou e nenhum índice roda depois do retorno
+static void test_exception_is_rethrown_after_helpers_leave() {
+    for (int round = 0; round < 50; ++round) {
+        auto running = std::make_shared<std::atomic<int>>(0);
+        auto after_return = std::make_shared<std::atomic<bool>>(false);
+        auto returned = std::make_shared<std::atomic<bool>>(false);
+        bool caught = false;
+        try {
+            parallel_for(64, [=](size_t index) {
+                ++*running;
+                *after_return = *after_return || *returned;
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                --*running;
+                if (index % 7 == 3) {
+                    throw std::runtime_error("falha no índice");
+                }
+            });
+        } catch (const std::runtime_error &) {
+            caught = true;
+        }
+        *returned = true;
+        CHECK(caught);
+        CHECK(*running == 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        CHECK(!*after_return);
+    }
+}
+
+// O laço continua utilizável depois de uma exceção
+static void test_usable_after_exception() {
+    try {
+        parallel_for(8, [](size_t) { throw std::logic_error("sempre"); });
+    } catch (const std::logic_error &) {
+    }
+    std::atomic<size_t> sum{ 0 };
+    parallel_for(100, [&](size_t index) { sum += index; });
+    CHECK(sum == 4950);
+}
+
+int main() {
+    test_every_index_once();
+    test_exception_is_rethrown_after_helpers_leave();
+    test_usable_after_exception();
+    return CHECK_RESULT();
+}